@@ -1,4 +1,6 @@
 #include "bitboard.hpp"
+#include "movegen.hpp"
+#include "tt.hpp"
 
 namespace Mufasa{
    Move::Move(int start, int end, int flags){
@@ -66,7 +68,6 @@ namespace Mufasa{
    }
 
    Bitboard::Bitboard(){
-      initPSQT();
       clearBoard();
    }
 
@@ -79,7 +80,6 @@ namespace Mufasa{
       
       for(int i = 0; i < 2; i++){
          occupancy[i] = 0ULL;
-         attacks[i] = 0ULL;
       }
       
       for(int i = 0; i < 64; i++){
@@ -87,995 +87,324 @@ namespace Mufasa{
       }
 
       fullboard = 0ULL;
-      checkmask = -1; // sets attacks to all ones
-      pinsD12 = 0ULL; // sets pins to all zeros
-      pinsHV = 0ULL;
 
-      moves.clear();
-
-      tt.clear();
-      tt.resize(0x800000);
-   
-      repetitions.assign(0x800000, 0);
+      psqtMG = 0;
+      psqtEG = 0;
+      phase = 0;
    }
    
    int Bitboard::countFullMoves() const{
-      return history.back().fullMoves;
+      return history[gamePly].fullMoves;
    }
 
-   uint64_t Bitboard::countMoves() const{
-      return moves.size();
-   }
-   
-   void Bitboard::fillKingAttacks(Color side){
-      int figure = Figure::KING - 1;
-      uint64_t kings = pieces[figure][side];
-      
-      while(kings != 0ULL){
-         int square = bitScanPop(kings);
-         uint64_t mask = magics.kingMoves[square];
-         attacks[side] |= mask;
-      }
-   }
-
-   void Bitboard::fillPawnAttacks(Color side){
-      int figure = Figure::PAWN - 1;
-      uint64_t pawns = pieces[figure][side];
-
-      while(pawns != 0ULL){
-         int square = bitScanPop(pawns);
-         uint64_t mask;
-         if(side == Color::WHITE)
-            mask = magics.wpawnAttacks[square];
-         else
-            mask = magics.bpawnAttacks[square];
+   bool Bitboard::isSquareAttacked(int square, Color by, uint64_t occupied) const{
+      const uint64_t queens = pieces[Figure::QUEEN - 1][by];
+      const uint64_t pawnAttacks = (by == Color::WHITE) ? Magics::bpawnAttacks[square] : Magics::wpawnAttacks[square];
 
-         attacks[side] |= mask;
-      }
-   }
-   
-   void Bitboard::fillKnightAttacks(Color side){
-      int figure = Figure::KNIGHT - 1;
-      uint64_t knights = pieces[figure][side];
+      if(pawnAttacks & pieces[Figure::PAWN - 1][by]) return true;
+      if(Magics::knightMoves[square] & pieces[Figure::KNIGHT - 1][by]) return true;
+      if(Magics::kingMoves[square] & pieces[Figure::KING - 1][by]) return true;
+      
+      if(Magics::getBishopAttacks(occupied, square) & (pieces[Figure::BISHOP - 1][by] | queens)) return true;
+      if(Magics::getRookAttacks(occupied, square) & (pieces[Figure::ROOK - 1][by] | queens)) return true;
 
-      while(knights != 0ULL){
-         int square = bitScanPop(knights);
-         uint64_t mask = magics.knightMoves[square];
-         
-         attacks[side] |= mask;
-      }
+      return false;
    }
 
-   void Bitboard::fillRookAttacks(Color side){
-      int figure = Figure::ROOK - 1;
-      uint64_t rooks = pieces[figure][side];
-      uint64_t opKings = pieces[Figure::KING - 1][++side];
+   // pieces of both colors attacking the square through the given occupancy
+   uint64_t Bitboard::attackersTo(int square, uint64_t occupied) const{
+      const uint64_t queens = pieces[Figure::QUEEN - 1][0] | pieces[Figure::QUEEN - 1][1];
+      const uint64_t bishops = pieces[Figure::BISHOP - 1][0] | pieces[Figure::BISHOP - 1][1] | queens;
+      const uint64_t rooks = pieces[Figure::ROOK - 1][0] | pieces[Figure::ROOK - 1][1] | queens;
 
-      while(rooks != 0ULL){
-         int square = bitScanPop(rooks);
-         uint64_t mask = magics.getRookAttacks(fullboard ^ opKings, square);
+      uint64_t attackers = 0ULL;
+      attackers |= Magics::bpawnAttacks[square] & pieces[Figure::PAWN - 1][Color::WHITE];
+      attackers |= Magics::wpawnAttacks[square] & pieces[Figure::PAWN - 1][Color::BLACK];
+      attackers |= Magics::knightMoves[square] & (pieces[Figure::KNIGHT - 1][0] | pieces[Figure::KNIGHT - 1][1]);
+      attackers |= Magics::kingMoves[square] & (pieces[Figure::KING - 1][0] | pieces[Figure::KING - 1][1]);
+      attackers |= Magics::getBishopAttacks(occupied, square) & bishops;
+      attackers |= Magics::getRookAttacks(occupied, square) & rooks;
 
-         attacks[side] |= mask;
-      }
+      return attackers & occupied;
    }
 
-   void Bitboard::fillBishopAttacks(Color side){
-      int figure = Figure::BISHOP - 1;
-      uint64_t bishops = pieces[figure][side];
-      uint64_t opKings = pieces[Figure::KING - 1][++side];
+   // material values used for exchanges, the king can never be traded
+   const int seeValue[7] = {0, 100, 300, 300, 500, 900, 20000};
 
-      while(bishops != 0ULL){
-         int square = bitScanPop(bishops);
-         uint64_t mask = magics.getBishopAttacks(fullboard ^ opKings, square);
+   // Static exchange evaluation, material won by the side making the capture
+   // once both sides keep recapturing on the target square with their least valuable piece
+   // and stop as soon as continuing would lose material
+   //
+   // Sliders behind the capturing pieces join in as the line opens up, pins are ignored
+   // Exchanges are cut short once the outcome is decided, so only the sign of the result is exact
+   int Bitboard::see(const Move move) const{
+      const int from = move.start();
+      const int to = move.end();
 
-         attacks[side] |= mask;
-      }
-   }
+      int gain[32];
+      int depth = 0;
+
+      Figure attacker = mailbox[from].getFigure();
+      Color side = mailbox[from].getColor();
+      uint64_t occupied = fullboard;
 
-   void Bitboard::fillQueenAttacks(Color side){
-      int figure = Figure::QUEEN - 1;
-      uint64_t queens = pieces[figure][side];
-      uint64_t opKings = pieces[Figure::KING - 1][++side];
+      gain[0] = seeValue[mailbox[to].getFigure()];
 
-      while(queens != 0ULL){
-         int square = bitScanPop(queens);
-         uint64_t mask = magics.getBishopAttacks(fullboard ^ opKings, square) |
-                         magics.getRookAttacks(fullboard ^ opKings, square);
-         attacks[side] |= mask;
+      if(move.getFlags() & Move::ENPASSANT){
+         gain[0] = seeValue[Figure::PAWN];
+         occupied ^= (1ULL << history[gamePly].doublePushSq);
       }
-   }
 
-   void Bitboard::fillAttackMask(Color side){
-      attacks[side] = 0ULL;
+      // capturing something at least as valuable can not lose material
+      if(seeValue[attacker] <= gain[0]) return gain[0];
 
-      fillKingAttacks(side);
-      fillPawnAttacks(side);
-      fillRookAttacks(side);
-      fillKnightAttacks(side);
-      fillBishopAttacks(side);
-      fillQueenAttacks(side);
-   }
+      const uint64_t queens = pieces[Figure::QUEEN - 1][0] | pieces[Figure::QUEEN - 1][1];
+      const uint64_t bishops = pieces[Figure::BISHOP - 1][0] | pieces[Figure::BISHOP - 1][1] | queens;
+      const uint64_t rooks = pieces[Figure::ROOK - 1][0] | pieces[Figure::ROOK - 1][1] | queens;
 
-   void Bitboard::fillCheckMask(){
-      checkmask = -1;
+      uint64_t attackers = attackersTo(to, occupied);
+      uint64_t fromBit = (1ULL << from);
 
-      int friends = sideToMove();
-      int op = ++sideToMove();
+      while(fromBit){
+         depth++;
+         gain[depth] = seeValue[attacker] - gain[depth - 1];
 
-      int figure = Figure::KING - 1;
-      int pawn = Figure::PAWN - 1;
-      int knight = Figure::KNIGHT - 1;
-      int bishop = Figure::BISHOP - 1;
-      int rook = Figure::ROOK - 1;
-      int queen = Figure::QUEEN - 1;
-      
-      if(pieces[figure][friends] == 0ULL){
-           std::cout << "ERROR: " << std::endl;
-           for(const auto& x : history){
-               std::cout << x.previous << " ";
-           }
-           std::cout << std::endl;
-      }
+         // neither side wants to continue the exchange
+         if(std::max(-gain[depth - 1], gain[depth]) < 0) break;
 
-      assert(pieces[figure][friends] != 0ULL);
+         occupied ^= fromBit;
 
-      int sq = bitScan(pieces[figure][friends]);
-      
-      uint64_t checks = 0ULL;
-      uint64_t kingbit = (1ULL << sq);
-
-      uint64_t opBQ = pieces[bishop][op] | pieces[queen][op];
-      uint64_t opRQ = pieces[rook][op] | pieces[queen][op];
-      uint64_t opKN = pieces[knight][op];
-      uint64_t opPW = pieces[pawn][op];
-
-      for(int dir = 0; dir < 2; dir++){
-         uint64_t attacks = magics.getPositiveRayAttacks(fullboard, dir, sq);
-         int blockerSq = bitScanRev(attacks | kingbit);
-         if((1ULL << blockerSq) & opBQ){
-            checks |= attacks;
+         if(attacker == Figure::PAWN || attacker == Figure::BISHOP || attacker == Figure::QUEEN){
+            attackers |= Magics::getBishopAttacks(occupied, to) & bishops;
          }
-      }
 
-      for(int dir = 2; dir < 4; dir++){
-         uint64_t attacks = magics.getNegativeRayAttacks(fullboard, dir, sq);
-         int blockerSq = bitScan(attacks | kingbit);
-         if((1ULL << blockerSq) & opBQ){
-            checks |= attacks;
+         if(attacker == Figure::ROOK || attacker == Figure::QUEEN){
+            attackers |= Magics::getRookAttacks(occupied, to) & rooks;
          }
-      }
 
-      for(int dir = 4; dir < 6; dir++){
-         uint64_t attacks = magics.getPositiveRayAttacks(fullboard, dir, sq);
-         int blockerSq = bitScanRev(attacks | kingbit);
-         if((1ULL << blockerSq) & opRQ){
-            checks |= attacks;
-         }
-      }
+         attackers &= occupied;
+         side = ++side;
+         fromBit = 0ULL;
 
-      for(int dir = 6; dir < 8; dir++){
-         uint64_t attacks = magics.getNegativeRayAttacks(fullboard, dir, sq);
-         int blockerSq = bitScan(attacks | kingbit);
-         if((1ULL << blockerSq) & opRQ){
-            checks |= attacks;
+         for(int fig = Figure::PAWN; fig <= Figure::KING; fig++){
+            uint64_t candidates = attackers & pieces[fig - 1][side];
+            if(candidates){
+               fromBit = candidates & -candidates;
+               attacker = static_cast<Figure>(fig);
+               break;
+            }
          }
       }
 
-      uint64_t knightAttacks = magics.knightMoves[sq];
-      checks |= (knightAttacks & opKN);
-
-      uint64_t pawnAttacks;
-      if(friends == Color::WHITE) pawnAttacks = magics.wpawnAttacks[sq];
-      else pawnAttacks = magics.bpawnAttacks[sq];
-      
-      checks |= (pawnAttacks & opPW);
-
-      if(checks != 0ULL){
-         const int checkers = popCount(checks & fullboard);
-         if(checkers > 1) checkmask = 0ULL;
-         else checkmask = checks;
-      }
-   }
-
-   void Bitboard::fillPinMask(){
-      pinsHV = 0ULL;
-      pinsD12 = 0ULL;
-
-      const int friends = sideToMove();
-      const int op = ++sideToMove();
-
-      const int king = Figure::KING - 1;
-      const int rook = Figure::ROOK - 1;
-      const int bishop = Figure::BISHOP - 1;
-      const int queen = Figure::QUEEN - 1;
-
-      int sq = bitScan(pieces[king][friends]);
-
-      uint64_t opRQ = pieces[rook][op] | pieces[queen][op];
-      uint64_t opBQ = pieces[bishop][op] | pieces[queen][op];
-
-      uint64_t pinners = magics.getXRayBishopAttacks(fullboard, occupancy[friends], sq) & opBQ;
-      while(pinners != 0ULL){
-         int enemy = bitScanPop(pinners);
-         pinsD12 |= magics.flesh[sq][enemy] & fullboard;
-      }
-
-      pinners = magics.getXRayRookAttacks(fullboard, occupancy[friends], sq) & opRQ;
-      while(pinners != 0ULL){
-         int enemy = bitScanPop(pinners);
-         pinsHV |= magics.flesh[sq][enemy] & fullboard;
-      }
-   }
-   
-   void Bitboard::singleBishopMoves(int sq){
-      int king = Figure::KING - 1;
-      int friends = sideToMove();
-      uint64_t attacks = magics.getBishopAttacks(fullboard, sq);
-      uint64_t legals = attacks & ~occupancy[friends];
-      
-      legals &= checkmask;
-      
-      bool pinnedHV  = (1ULL << sq) & pinsHV;
-      bool pinnedD12 = (1ULL << sq) & pinsD12;
-
-      if(pinnedHV) return;
-      
-      int kingSq = bitScan(pieces[king][friends]);
-
-      if(pinnedD12){
-         legals &= magics.connect[sq][kingSq];
+      while(--depth){
+         gain[depth - 1] = -std::max(-gain[depth - 1], gain[depth]);
       }
 
-      while(legals != 0ULL){
-         int target = bitScanPop(legals);
-         pushMove(Move(sq, target));
-      }
+      return gain[0];
    }
-   
-   void Bitboard::fillBishopMoves(){
-      int friends = sideToMove();
-      int figure = Figure::BISHOP - 1;
-      uint64_t bishops = pieces[figure][friends];
-      bishops &= ~pinsHV;
-
-      while(bishops != 0ULL){
-         int sq = bitScanPop(bishops);
-         singleBishopMoves(sq);
-      }
-   }
-   
-   void Bitboard::singleRookMoves(int sq){
-      int friends = sideToMove();
-      const int king = Figure::KING - 1;
-      uint64_t attacks = magics.getRookAttacks(fullboard, sq);
-      uint64_t legals = attacks & ~occupancy[friends];
-      legals &= checkmask;
-
-      bool pinnedHV  = (1ULL << sq) & pinsHV;
-      bool pinnedD12 = (1ULL << sq) & pinsD12;
-      
-      if(pinnedD12) return;
 
-      if(pinnedHV){
-         int kingSq = bitScan(pieces[king][friends]);
-         legals &= magics.connect[sq][kingSq];
-      }
+   bool Bitboard::inCheck() const{
+      Color friends = sideToMove();
+      int kingSq = bitScan(pieces[Figure::KING - 1][friends]);
 
-      while(legals != 0ULL){
-         int target = bitScanPop(legals);
-         pushMove(Move(sq, target));
-      }
+      return isSquareAttacked(kingSq, ++friends, fullboard);
    }
 
-   void Bitboard::fillRookMoves(){
-      int friends = sideToMove();
-      int figure = Figure::ROOK - 1;
-      uint64_t rooks = pieces[figure][friends];
-      rooks &= (~pinsD12);
+   // Counts how many times the current position occurred in the game,
+   // positions before the last irreversible move can not repeat
+   int Bitboard::countRepetitions() const{
+      int count = 1;
+      int reach = std::min<int>(gamePly, history[gamePly].halfMoves);
 
-      while(rooks != 0ULL){
-         int sq = bitScanPop(rooks);
-         singleRookMoves(sq);
+      for(int i = 2; i <= reach; i += 2){
+         if(history[gamePly - i].zobrist == zobrist) count++;
       }
-   }
-
-   void Bitboard::fillQueenMoves(){
-      int friends = sideToMove();
-      int figure = Figure::QUEEN - 1;
-      uint64_t slayqueens = pieces[figure][friends];
 
-      while(slayqueens != 0ULL){
-         int sq = bitScanPop(slayqueens);
-         singleBishopMoves(sq);
-         singleRookMoves(sq);
-      }
+      return count;
    }
-   
-   template<GenType type>
-   void Bitboard::fillWhitePawnMoves(){
-      const int friends = Color::WHITE;
-      const int enemies = Color::BLACK;
 
-      const int pawn = Figure::PAWN - 1;
-      const int king = Figure::KING - 1;
-      const int rook = Figure::ROOK - 1;
-      const int queen = Figure::QUEEN - 1;
+   // Checks whether the move could have been produced by the generator
+   // in the current position, ignoring checks and pins
+   bool Bitboard::isPseudoLegal(const Move move) const{
+      const Color friends = sideToMove();
+      const Color enemies = ++friends;
 
-      uint64_t opRQ = (pieces[rook][enemies] | pieces[queen][enemies]);
+      const int flags = move.getFlags();
+      const int from = move.start();
+      const int to = move.end();
+      const uint64_t target = (1ULL << to);
+      const Piece piece = mailbox[from];
 
-      int kingsq = bitScan(pieces[king][friends]);     
+      if(!piece || piece.getColor() != friends) return false;
+      if(occupancy[friends] & target) return false;
       
-      uint64_t pawns = pieces[pawn][friends];
-      const uint64_t rank7 = 0x00FF000000000000ULL;
-      if constexpr (type == GenType::PROMOTION){
-         pawns &= rank7; 
-      }
-      else{
-         pawns &= (~rank7);
-      }
+      const int promotions = Move::TOQUEEN | Move::TOROOK | Move::TOBISHOP | Move::TOKNIGHT;
 
-      uint64_t pushable = pawns & ~pinsD12 
-      & ~(pinsHV & (magics.rightHalf[kingsq] | magics.leftHalf[kingsq]));
-      
-      // bitmasks for pawns that can capture left/right
-      // incorporates pinned pawns which can only capture in the direction away from king
-      // left captures are only available for white pinned pawns if they are north west or south east from the king
-      // (from the white player point of view)
-      //
-      // right captures are only available for white pinned pawns if they are south west or north east from the king
-      
-      uint64_t diagleft = pawns & ~pinsHV & ~(pinsD12 & (magics.rays[1][kingsq] | magics.rays[2][kingsq]));
-      uint64_t diagright = pawns & ~pinsHV & ~(pinsD12 & (magics.rays[0][kingsq] | magics.rays[3][kingsq]));
-
-      uint64_t targets = 0ULL;
-      
-      uint64_t single = (pushable << 8) & ~fullboard;
-      targets |= (single & checkmask);
-      while(targets != 0ULL){
-         int to = bitScanPop(targets);
-         int from = (to - 8);
-
-         if constexpr (type != GenType::PROMOTION){
-            pushMove(Move(from, to));
-         }
-         else{
-            pushMove(Move(from, to, Move::PROMOTION | Move::TOQUEEN));
-            pushMove(Move(from, to, Move::PROMOTION | Move::TOROOK));
-            pushMove(Move(from, to, Move::PROMOTION | Move::TOBISHOP));
-            pushMove(Move(from, to, Move::PROMOTION | Move::TOKNIGHT));
-         }
-      }
-      
-      if constexpr (type != GenType::PROMOTION){
-         uint64_t rank4 = 0x00000000FF000000ULL;
-         uint64_t push = (single << 8) & ~fullboard & rank4;
-         targets |= (push & checkmask);
-         while(targets != 0ULL){
-            int to = bitScanPop(targets);
-            int from = (to - 16);
-            pushMove(Move(from, to, Move::DOUBLEPUSH));
-         }
-      }
-      
-      uint64_t skipAfile = 0xFEFEFEFEFEFEFEFEULL;
-      uint64_t left = ((skipAfile & diagleft) << 7) & fullboard & ~occupancy[friends];
-      targets |= (left & checkmask);
-      while(targets != 0ULL){
-         int to = bitScanPop(targets);
-         int from = (to - 7);
- 
-         if constexpr (type != GenType::PROMOTION){
-            pushMove(Move(from, to));
-         }
-         else{
-            pushMove(Move(from, to, Move::PROMOTION | Move::TOQUEEN  | Move::CAPTURE));
-            pushMove(Move(from, to, Move::PROMOTION | Move::TOROOK   | Move::CAPTURE));
-            pushMove(Move(from, to, Move::PROMOTION | Move::TOBISHOP | Move::CAPTURE));
-            pushMove(Move(from, to, Move::PROMOTION | Move::TOKNIGHT | Move::CAPTURE));
-         }
-      }
+      switch(piece.getFigure()){
+         case Figure::PAWN:{
+            const int forward = (friends == Color::WHITE) ? 8 : -8;
+            const uint64_t startRank = (friends == Color::WHITE) ? 0x000000000000FF00ULL : 0x00FF000000000000ULL;
+            const uint64_t lastRank  = (friends == Color::WHITE) ? 0xFF00000000000000ULL : 0x00000000000000FFULL;
+            const uint64_t captures  = (friends == Color::WHITE) ? Magics::wpawnAttacks[from] : Magics::bpawnAttacks[from];
 
-      uint64_t skipHfile = 0x7F7F7F7F7F7F7F7FULL;
-      uint64_t right = ((skipHfile & diagright) << 9) & fullboard & ~occupancy[friends];
-      targets |= (right & checkmask);
-      while(targets != 0ULL){
-         int to = bitScanPop(targets);
-         int from = (to - 9);
-      
-         if constexpr (type != GenType::PROMOTION){
-            pushMove(Move(from, to));
-         }
-         else{
-            pushMove(Move(from, to, Move::PROMOTION | Move::TOQUEEN  | Move::CAPTURE));
-            pushMove(Move(from, to, Move::PROMOTION | Move::TOROOK   | Move::CAPTURE));
-            pushMove(Move(from, to, Move::PROMOTION | Move::TOBISHOP | Move::CAPTURE));
-            pushMove(Move(from, to, Move::PROMOTION | Move::TOKNIGHT | Move::CAPTURE));
-         }
-      }
-      
+            if(flags & Move::ENPASSANT){
+               return flags == (Move::ENPASSANT | Move::CAPTURE) && (captures & target) && to == history[gamePly].epTargetSq;
+            }
 
-      // en passant
-      if constexpr (type != GenType::PROMOTION){
-         int epTargetSq = history.back().epTargetSq;
-         int targetPawn = (epTargetSq - 8);
+            if(flags & Move::DOUBLEPUSH){
+               uint64_t path = target | (1ULL << (from + forward));
+               return flags == Move::DOUBLEPUSH && ((1ULL << from) & startRank) && to == from + 2 * forward && !(path & fullboard);
+            }
 
-         if(epTargetSq != -1 && !(pinsD12 & (1ULL << targetPawn))){
-            // check if en passant is a valid response to the check
-            uint64_t checkmaskEP = checkmask;
-            checkmaskEP &= (1ULL << (epTargetSq - 8));
-            checkmaskEP <<= 8;
+            bool capture = (captures & target & occupancy[enemies]);
+            bool push = (to == from + forward) && !(target & fullboard);
+            
+            if(!capture && !push) return false;
 
-            if(!((1ULL << epTargetSq) & checkmaskEP)) return;
+            if(target & lastRank){
+               int promotion = flags & promotions;
+               int expected = Move::PROMOTION | (capture ? Move::CAPTURE : 0);
+               
+               // exactly one piece to promote to
+               return (flags & ~promotions) == expected && promotion && !(promotion & (promotion - 1));
+            }
 
-            uint64_t candidates = 0ULL;
-            
-            // en passant target square is one rank above the black pawn
-            uint64_t minusPawn = fullboard ^ (1ULL << (epTargetSq - 8));
-            // check if en passant capture can result in check from enemy rook/queen on the same rank
-            uint64_t pinners = magics.getXRayRookAttacks(minusPawn, occupancy[friends], kingsq) & opRQ;
-            
-            uint64_t pinned = 0ULL;
-            while(pinners != 0ULL){
-               int enemy = bitScanPop(pinners);
-               pinned |= magics.flesh[kingsq][enemy];
+            return !flags;
+         }
+         case Figure::KNIGHT:
+            return !flags && (Magics::knightMoves[from] & target);
+         case Figure::BISHOP:
+            return !flags && (Magics::getBishopAttacks(fullboard, from) & target);
+         case Figure::ROOK:
+            return !flags && (Magics::getRookAttacks(fullboard, from) & target);
+         case Figure::QUEEN:
+            return !flags && ((Magics::getBishopAttacks(fullboard, from) | Magics::getRookAttacks(fullboard, from)) & target);
+         case Figure::KING:{
+            if(!(flags & Move::CASTLING)){
+               return !flags && (Magics::kingMoves[from] & target);
             }
-            
-            // check if we have a pawn to the left of double pushed pawn
-            left = (1ULL << (epTargetSq - 9));
-            left &= ~(pinsD12 & (magics.rays[0][kingsq] | magics.rays[3][kingsq]));
-            left &= skipHfile;
-            
-            // check if we have a pawn to the right of double pushed pawn
-            right = (1ULL << (epTargetSq - 7));
-            right &= ~(pinsD12 & (magics.rays[1][kingsq] | magics.rays[2][kingsq]));
-            right &= skipAfile;
-            
-            candidates |= left;
-            candidates |= right;
-            candidates &= ~pinsHV;
 
-            // skip pawn moves that could result in check from enemy rook/queen on the same rank
-            candidates &= ~pinned;
-            candidates &= pawns;
+            uint8_t castling = history[gamePly].castling;
+            if(friends == Color::WHITE) castling >>= 2;
             
-            while(candidates != 0ULL){
-               int from = bitScanPop(candidates);
-               pushMove(Move(from, epTargetSq, Move::ENPASSANT | Move::CAPTURE));
+            int rookSq = (from - (from % 8));
+            if(flags == (Move::CASTLING | Move::KINGSIDE)){
+               rookSq += 7;
+               return (castling & 0b10) && to == from + 2 && !(Magics::flesh[from][rookSq] & fullboard);
+            }
+            if(flags == (Move::CASTLING | Move::QUEENSIDE)){
+               return (castling & 0b01) && to == from - 2 && !(Magics::flesh[from][rookSq] & fullboard);
             }
+
+            return false;
          }
+         default:
+            return false;
       }
    }
 
-   template<GenType type>
-   void Bitboard::fillBlackPawnMoves(){
-      const int friends = Color::BLACK;
-      const int enemies = Color::WHITE;
-      const int pawn = Figure::PAWN - 1;
-      const int king = Figure::KING - 1;
-      const int rook = Figure::ROOK - 1;
-      const int queen = Figure::QUEEN - 1;
-
-      uint64_t opRQ = (pieces[rook][enemies] | pieces[queen][enemies]);
+   // Full legality check for a single move without generating the rest,
+   // used to validate moves coming from the transposition table
+   bool Bitboard::isLegal(const Move move){
+      if(!isPseudoLegal(move)) return false;
 
-      int kingsq = bitScan(pieces[king][friends]);     
-      
-      uint64_t pawns = pieces[pawn][friends];
-      const uint64_t rank2 = 0x000000000000FF00ULL;
-      if constexpr (type == GenType::PROMOTION){
-         pawns &= rank2; 
-      }
-      else{
-         pawns &= (~rank2);
-      }
+      const Color friends = sideToMove();
+      const Color enemies = ++friends;
+      const int king = Figure::KING - 1;
 
-      uint64_t pushable = pawns & ~pinsD12
-      & ~(pinsHV & (magics.rightHalf[kingsq] | magics.leftHalf[kingsq]));
-      
-      // bitmasks for pawns that can capture left/right
-      // incorporates pinned pawns which can only capture in the direction away from king
-      // left captures are only available for black pinned pawns if they are south west or north east from the king
-      // (from the white player point of view)
-      //
-      // right captures are only available for black pinned pawns if they are north west or south east from the king
-      uint64_t diagleft = pawns & ~pinsHV & ~(pinsD12 & (magics.rays[0][kingsq] | magics.rays[3][kingsq]));
-      uint64_t diagright = pawns & ~pinsHV & ~(pinsD12 & (magics.rays[1][kingsq] | magics.rays[2][kingsq]));
-
-      uint64_t targets = 0ULL;
-      
-      uint64_t single = (pushable >> 8) & ~fullboard;
-      targets |= (single & checkmask);
-      while(targets != 0ULL){
-         int to = bitScanPop(targets);
-         int from = (to + 8);
-
-         if constexpr (type != GenType::PROMOTION){
-            pushMove(Move(from, to));
+      // king can not castle out of, through or into the check
+      if(move.getFlags() & Move::CASTLING){
+         int step = (move.getFlags() & Move::KINGSIDE) ? 1 : -1;
+         for(int sq = move.start(); sq != move.end() + step; sq += step){
+            if(isSquareAttacked(sq, enemies, fullboard)) return false;
          }
-         else{
-            pushMove(Move(from, to, Move::PROMOTION | Move::TOQUEEN));
-            pushMove(Move(from, to, Move::PROMOTION | Move::TOROOK));
-            pushMove(Move(from, to, Move::PROMOTION | Move::TOBISHOP));
-            pushMove(Move(from, to, Move::PROMOTION | Move::TOKNIGHT));
-         }
-      }
-      
-      if constexpr (type != GenType::PROMOTION){
-         uint64_t rank5 = 0x000000FF00000000ULL;
-         uint64_t push = (single >> 8) & ~fullboard & rank5;
-         targets |= (push & checkmask);
-         
-         while(targets != 0ULL){
-            int to = bitScanPop(targets);
-            int from = (to + 16);
-            pushMove(Move(from, to, Move::DOUBLEPUSH));
-         }
-      }
-      
-      uint64_t skipAfile = 0xFEFEFEFEFEFEFEFEULL;
-      uint64_t left = ((skipAfile & diagleft) >> 9) & fullboard & ~occupancy[friends];
-      targets = (left & checkmask);
-      
-      while(targets != 0ULL){
-         int to = bitScanPop(targets);
-         int from = (to + 9);
- 
-         if constexpr (type != GenType::PROMOTION){
-            pushMove(Move(from, to));
-         }
-         else{
-            pushMove(Move(from, to, Move::PROMOTION | Move::TOQUEEN  | Move::CAPTURE));
-            pushMove(Move(from, to, Move::PROMOTION | Move::TOROOK   | Move::CAPTURE));
-            pushMove(Move(from, to, Move::PROMOTION | Move::TOBISHOP | Move::CAPTURE));
-            pushMove(Move(from, to, Move::PROMOTION | Move::TOKNIGHT | Move::CAPTURE));
-         }
-      }
 
-      uint64_t skipHfile = 0x7F7F7F7F7F7F7F7FULL;
-      uint64_t right = ((skipHfile & diagright) >> 7) & fullboard & ~occupancy[friends];
-      targets |= (right & checkmask);
-      while(targets != 0ULL){
-         int to = bitScanPop(targets);
-         int from = (to + 7);
-      
-         if constexpr (type != GenType::PROMOTION){
-            pushMove(Move(from, to));
-         }
-         else{
-            pushMove(Move(from, to, Move::PROMOTION | Move::TOQUEEN  | Move::CAPTURE));
-            pushMove(Move(from, to, Move::PROMOTION | Move::TOROOK   | Move::CAPTURE));
-            pushMove(Move(from, to, Move::PROMOTION | Move::TOBISHOP | Move::CAPTURE));
-            pushMove(Move(from, to, Move::PROMOTION | Move::TOKNIGHT | Move::CAPTURE));
-         }
+         return true;
       }
 
-      // en passant
-      if constexpr (type != GenType::PROMOTION){
-         int epTargetSq = history.back().epTargetSq;
-         int targetPawn = (epTargetSq + 8);
-
-         if(epTargetSq != -1 && !(pinsD12 & (1ULL << targetPawn))){
-            // check if enpassant is a valid response to check
-            uint64_t checkmaskEP = checkmask;
-            checkmaskEP &= (1ULL << (epTargetSq + 8));
-            checkmaskEP >>= 8;
-            
-            if(!((1ULL << epTargetSq) & checkmaskEP)) return;
-
-            uint64_t candidates = 0ULL;
-            
-            // en passant target square is one rank above the black pawn
-            uint64_t minusPawn = fullboard ^ (1ULL << (epTargetSq + 8));
-            // check if en passant capture can result in check from enemy rook/queen on the same rank
-            uint64_t pinners = magics.getXRayRookAttacks(minusPawn, occupancy[friends], kingsq) & opRQ;
-            
-            uint64_t pinned = 0ULL;
-            while(pinners != 0ULL){
-               int enemy = bitScanPop(pinners);
-               pinned |= magics.flesh[kingsq][enemy];
-            }
-
-            right = (1ULL << (epTargetSq + 7));
-            right &= ~(pinsD12 & (magics.rays[1][kingsq] | magics.rays[2][kingsq]));
-            right &= skipHfile;
-            
-            left = (1ULL << (epTargetSq + 9));
-            left &= ~(pinsD12 & (magics.rays[0][kingsq] | magics.rays[3][kingsq]));
-            left &= skipAfile;
-            
-            candidates |= right;
-            candidates |= left;
-  
-            candidates &= ~pinsHV;
-            candidates &= ~pinned;
-            candidates &= pawns;
-
-            while(candidates != 0ULL){
-               int from = bitScanPop(candidates);
-               pushMove(Move(from, epTargetSq, Move::ENPASSANT | Move::CAPTURE));
-            }
-         }
-      }
-   }
+      makeMove(move);
+      bool legal = !isSquareAttacked(bitScan(pieces[king][friends]), enemies, fullboard);
+      unmakeMove(move);
 
-   void Bitboard::fillPawnMoves(){
-      if(sideToMove() == Color::WHITE){
-         fillWhitePawnMoves<GenType::NONPROMOTION>();
-         fillWhitePawnMoves<GenType::PROMOTION>();
-      }
-      else{
-         fillBlackPawnMoves<GenType::NONPROMOTION>();
-         fillBlackPawnMoves<GenType::PROMOTION>();
-      }
+      return legal;
    }
    
-   void Bitboard::fillKingMoves(){
-      Color friends = sideToMove();
-      int enemies = ++sideToMove();
+   void Bitboard::fillMoves(MoveList &moveList, GenType type){
+      moveList.clear();
 
-      int figure = Figure::KING - 1;
-      uint64_t king = pieces[figure][friends];
-      
-      assert(king != 0ULL);
-      int sq = bitScan(king);
-      uint64_t moves = magics.kingMoves[sq];
-      moves &= ~(occupancy[friends]);
-      moves &= ~attacks[enemies];   
-      while(moves != 0ULL){
-         int target = bitScanPop(moves);
-         pushMove(Move(sq, target));
-      }
-      
-      if(king & attacks[enemies]) return;
-
-      // check for castling opportunities
-      uint8_t castling = history.back().castling;
-      if(friends == Color::WHITE) castling >>= 2;
-      
-      // check kingside castling
-      if(castling & 0b10){
-         int target = sq + 2;
-         int rookSq = (sq - (sq % 8)) + 7;
-         uint64_t open = magics.flesh[sq][rookSq];
-         open &= fullboard;
-         
-         uint64_t safe = magics.flesh[sq][target + 1];
-         safe &= attacks[enemies];
-
-         if(!open && !safe){
-            pushMove(Move(sq, target, Move::CASTLING | Move::KINGSIDE));
-         }
-      }
-      
-      // check queenside castling
-      if(castling & 0b01){
-         int target = sq - 2;
-         int rookSq = (sq - (sq % 8));
-         uint64_t open = magics.flesh[sq][rookSq];
-         open &= fullboard;
-         
-         uint64_t safe = magics.flesh[sq][target - 1];
-         safe &= attacks[enemies];
+      auto push = [&moveList](const Move move){
+         moveList.push_back(move);
+      };
 
-         if(!open && !safe){
-            pushMove(Move(sq, target, Move::CASTLING | Move::QUEENSIDE));
-         }
+      switch(type){
+         case GenType::CAPTURE:
+            generateMoves<GenType::CAPTURE>(push);
+            break;
+         case GenType::QUIET:
+            generateMoves<GenType::QUIET>(push);
+            break;
+         default:
+            generateMoves<GenType::ALL>(push);
       }
    }
 
-   void Bitboard::fillKnightMoves(){
-      int friends = sideToMove();
-      int figure = Figure::KNIGHT - 1;
-      uint64_t knights = pieces[figure][friends] & ~(pinsHV | pinsD12);
-
-      while(knights != 0ULL){
-         int sq = bitScanPop(knights);
-         uint64_t targets = magics.knightMoves[sq] & ~occupancy[friends] & checkmask;
-         
-         while(targets != 0ULL){
-            int target = bitScanPop(targets);
-            pushMove(Move(sq, target));
-         }
-      }
+   // number of legal moves without generating them
+   uint64_t Bitboard::countLegal(){
+      MoveCounter counter;
+      generateMoves(counter);
+      return counter.count;
    }
 
-   void Bitboard::fillMoves(){
-      moves.clear();
-      
-      fillAttackMask(++sideToMove());
-      fillCheckMask();
-      fillPinMask();
-      
-      if(checkmask != 0ULL){
-         fillRookMoves();
-         fillBishopMoves();
-         fillQueenMoves();
-         fillKnightMoves();
-         fillPawnMoves();
-      }
+   // MVV-LVA guess of how good the move is
+   int Bitboard::scoreMove(const Move move) const{
+      int from = move.start();
+      int to = move.end();
+      int scoreGuess = 0;
 
-      fillKingMoves();
-   }
+      if(mailbox[to]){
+         scoreGuess += 10 * mailbox[to].getValue();
+         scoreGuess -= mailbox[from].getValue();
+      }
 
-   void Bitboard::orderMoves(std::vector<Move> &moveList, const Move ttmove){
-      for(auto& move : moveList){
-         int from = move.start();
-         int to = move.end();
-         int scoreGuess = 0;
+      if(move.getFlags() & Move::PROMOTION){
+         scoreGuess -= 100;
+         int promotion = 300;
          
-         if(move == ttmove){
-            scoreGuess += 10000;
+         if(move.getFlags() & Move::TOQUEEN){
+            promotion = 900;
          }
-
-         if(mailbox[to]){
-            scoreGuess += 10 * mailbox[to].getValue();
-            scoreGuess -= mailbox[from].getValue();
+         else if(move.getFlags() & Move::TOROOK){
+            promotion = 500;
          }
 
-         if(move.getFlags() & Move::PROMOTION){
-            scoreGuess -= 100;
-            int promotion = 300;
-            
-            if(move.getFlags() & Move::TOQUEEN){
-               promotion = 900;
-            }
-            else if(move.getFlags() & Move::TOROOK){
-               promotion = 500;
-            }
-
-            scoreGuess += promotion;
-         }
-
-         move.score = scoreGuess;
+         scoreGuess += promotion;
       }
-      
-      
-      std::sort(moveList.begin(), moveList.end(), [](const Move x, const Move y){
-         return (x.score > y.score);
-      });
-   }
 
-   const std::vector<Move> Bitboard::getMoves(){
-      return moves;
+      return scoreGuess;
    }
 
-   void Bitboard::setDue(uint64_t due, uint64_t start){
-      duetime = due;
-      initime = start;
+   bool Bitboard::isCapture(const Move move) const{
+      return mailbox[move.end()] || (move.getFlags() & Move::ENPASSANT);
    }
-   
+
    // Used for time management only
    int Bitboard::gamephase() const{
-      int gamephase = 0;
-      uint64_t pieces = fullboard;
-      
-      while(pieces != 0){
-         int sq = bitScanPop(pieces);
-         int fig = mailbox[sq].getFigure() - 1;
-
-         gamephase += gamephaseInc[fig];
-      }
-      
-      if(gamephase > 24) gamephase = 24;
-
-      return gamephase;
+      return std::min(phase, 24);
    }
 
    int Bitboard::evaluate(){
-      int mgScore = 0;
-      int egScore = 0;
-      int gamephase = 0;
+      int gamephase = std::min(phase, 24);
+      int score = (psqtMG * gamephase + psqtEG * (24 - gamephase)) / 24;
 
-      int friendly = sideToMove();
-      uint64_t friends = occupancy[friendly];
-      uint64_t enemies = fullboard ^ friends;
-
-      while(friends != 0){
-         int sq = bitScanPop(friends);
-         int fig = mailbox[sq].getFigure() - 1;
-         
-         mgScore += tablesMG[friendly][fig][sq];
-         egScore += tablesEG[friendly][fig][sq];
-         gamephase += gamephaseInc[fig];
-      }
-      
-      while(enemies != 0){
-         int sq = bitScanPop(enemies);
-         int fig = mailbox[sq].getFigure() - 1;
-         int col = mailbox[sq].getColor();
-
-         mgScore -= tablesMG[col][fig][sq];
-         egScore -= tablesEG[col][fig][sq];
-         gamephase += gamephaseInc[fig];
-      }
-      
-      if(gamephase > 24) gamephase = 24;
-      
-      int score = (mgScore * gamephase + egScore * (24 - gamephase)) / 24;
-
-      return score;
+      return (sideToMove() == Color::WHITE) ? score : -score;
    }
 
-   std::pair<int, Move> Bitboard::bestMove(int depth){
-      Move bestMove;
-      int lastScore = 0;
-
-      for(int d = 1; d <= depth && now() < duetime; d++){
-         nodes = 0;
-         
-         fillMoves();
-         int score;
-         Move move;
-         std::vector<Move> principle;
-         
-         if(d <= 4){
-            std::tie(score, move) = negaMax(d, -oo, oo, principle);
-         }
-         else{
-            int window = 20;
-            int alpha = lastScore - window;
-            int beta = lastScore + window;
-            
-            std::tie(score, move) = negaMax(d, alpha, beta, principle);
-
-            while((score <= alpha || score >= beta) && (now() < duetime)){
-               if(score <= alpha){
-                  alpha -= window;
-               }
-               else if(score >= beta){
-                  beta += window;
-               }
-               
-               fillMoves();
-               std::tie(score, move) = negaMax(d, alpha, beta, principle);
-               window *= 2;
-            }
-         }
-
-         std::cout << "info depth " << d << " hits " << tthits << " nodes " << nodes << " time " << (now() - initime);
-         std::cout << " score cp " << score << " pv " << move << std::endl;
-         
-         if(now() < duetime){
-            lastScore = score;
-            bestMove = move;
-         }
-
-         if(score == oo) break;
-      }
-
-      return {lastScore, bestMove};
-   }
-   
-   // Quiescence Search
-   // https://www.chessprogramming.org/Quiescence_Search
-   // Searches for positions where there are no captures
-   // to avoid horizon effect in leaves
-
-   int Bitboard::quietSearch(int alpha, int beta){
-      int standPat = evaluate();
-
-      if(standPat >= beta) return beta;
-
-      if(alpha < standPat) alpha = standPat;
-      
-      if(now() >= duetime) return alpha;
-
-      std::vector<Move> ponder = moves;
-      orderMoves(ponder);
-      for(const auto &move : ponder){
-         int to = move.end();
-         if(!mailbox[to]) continue;
-
-         makeMove(move);
-         int score = -quietSearch(-beta, -alpha);
-         unmakeMove(move);
-
-         if(score >= beta) return beta;
-         if(score > alpha) alpha = score;
-      }
-      
-      return alpha;
-   }
-
-   std::pair<int, Move> Bitboard::negaMax(int depth, int alpha, int beta, std::vector<Move> &principle){
-      int max = -oo;
-      Move best = moves[0];
-
-      nodes++;
-
-      if(now() >= duetime){
-         return {beta, best};
-      }
-      
-      if(depth <= 0){
-         max = quietSearch(alpha, beta);
-         return {max, best};
-      }
-      
-      TTEntry tthit = tt[zobrist & 0x7FFFFF];
-      Move ttmove;
-      
-      if(tthit.key == zobrist){
-         ttmove = tthit.move;
-      
-         if(tthit.depth >= depth){
-            tthits++;
-
-            switch(tthit.type){
-               case EXACT:
-                  return {tthit.score, tthit.move};
-               case LOWER:
-                  if(tthit.score <= alpha)
-                     return {alpha, tthit.move};
-                  break;
-               case UPPER:
-                  if(tthit.score >= beta)
-                     return {beta, tthit.move};
-                  break;
-            }
-         }
-      }
-
-      std::vector<Move> ponder = moves;
-      orderMoves(ponder, ttmove);
-      
-      std::vector<Move> next;
-      
-      EntryType nodeType = LOWER;
-
-      for(const auto &move : ponder){
-         makeMove(move);
-         std::vector<Move> continuation;
-         auto [score, pv] = negaMax(depth - 1, -beta, -alpha, continuation);
-         
-         if(repetitions[zobrist & 0x7FFFFF] >= 3) score = 0;
-
-         unmakeMove(move);
-         
-         score = -score;
-
-         if(score > max){
-            next = continuation;
-            max = score;
-            if(alpha < max){
-               alpha = max;
-               nodeType = EXACT;
-            }
-            
-            best = move;
-         }
-
-         if(alpha >= beta){
-            nodeType = UPPER;
-            break;
-         }
-      }
-
-      if(!ponder.size()){ 
-         int friends = sideToMove();
-         int enemies = ++sideToMove();
-
-         if(!(attacks[enemies] & pieces[Figure::KING - 1][friends])){
-            max = 0;
-         }
-         else{
-            max = -oo;
-         }
-      }
-      
-      principle = next;
-      principle.push_back(best);
-
-      tt[zobrist & 0x7FFFFF] = {zobrist, age++, depth, max, best, nodeType};
-
-      return {max, best};
-   }
-   
    void Bitboard::set_position(std::string fen, std::vector<std::string> moves){
       int spaces = 0;
       int row = 7;
       int col = 0;
       
-      history.clear();
+      gamePly = 0;
       clearBoard();
 
       zobrist = 0ULL;
@@ -1145,11 +474,9 @@ namespace Mufasa{
          }
       }
 
-      history.push_back(state);
-      zobrist ^= history.back().zobristHash();
-
-      fillAttackMask(++sideToMove());
-      fillMoves(); 
+      zobrist ^= state.zobristHash();
+      state.zobrist = zobrist;
+      history[gamePly] = state;
 
       for(size_t i = 0; i < moves.size(); i++){
          makeMove(moveFromUCI(moves[i]));
@@ -1171,18 +498,20 @@ namespace Mufasa{
       return Piece(Figure::NONE, Color::WHITE);
    }
 
-   BoardState Bitboard::getState() const{
-      return history.back();
+   // state of the position the given number of plies ago
+   const BoardState& Bitboard::getState(int back) const{
+      assert(back <= gamePly);
+      return history[gamePly - back];
    }
 
-   Color Bitboard::sideToMove() const{
-      return history.back().sideToMove;
+   int Bitboard::getGamePly() const{
+      return gamePly;
    }
 
-   void Bitboard::pushMove(Move move){
-      moves.push_back(move);
+   Color Bitboard::sideToMove() const{
+      return history[gamePly].sideToMove;
    }
-   
+
    void Bitboard::remPiece(Piece piece, int square){
       if(!piece) return;
 
@@ -1194,7 +523,12 @@ namespace Mufasa{
       fullboard &= ~(1ULL << square);
       mailbox[square] = Piece();
    
-      zobrist ^= magics.zobristPieces[index][square];
+      zobrist ^= Magics::zobristPieces[index][color][square];
+
+      const int sign = (color == Color::WHITE) ? 1 : -1;
+      psqtMG -= sign * tablesMG[color][index][square];
+      psqtEG -= sign * tablesEG[color][index][square];
+      phase -= gamephaseInc[index];
    }
 
    void Bitboard::putPiece(Piece piece, int square){
@@ -1208,7 +542,12 @@ namespace Mufasa{
       fullboard |= (1ULL << square);
       mailbox[square] = piece;
    
-      zobrist ^= magics.zobristPieces[index][square];
+      zobrist ^= Magics::zobristPieces[index][color][square];
+
+      const int sign = (color == Color::WHITE) ? 1 : -1;
+      psqtMG += sign * tablesMG[color][index][square];
+      psqtEG += sign * tablesEG[color][index][square];
+      phase += gamephaseInc[index];
    }
 
    uint64_t Bitboard::zobristHash() const{
@@ -1227,14 +566,22 @@ namespace Mufasa{
       Piece before = mailbox[from];
       Piece after = before;
       
-      const BoardState* previous = &history.back();
+      assert(gamePly + 1 < MAX_HISTORY);
+
+      const BoardState* previous = &history[gamePly];
 
-      BoardState nextState;
-      nextState.sideToMove = ++sideToMove();
+      // the slot is reused, so every field has to be written
+      BoardState &nextState = history[gamePly + 1];
+      nextState.sideToMove = enemy;
       
       nextState.castling = previous->castling;   
       nextState.captured = capture;
+      nextState.doublePushSq = -1;
+      nextState.epTargetSq = -1;
       nextState.halfMoves = previous->halfMoves + 1;
+      
+      // captures and pawn moves are irreversible
+      if(capture || before.getFigure() == Figure::PAWN) nextState.halfMoves = 0;
       nextState.fullMoves = previous->fullMoves;
 
       if(color == Color::BLACK) nextState.fullMoves++;
@@ -1302,8 +649,7 @@ namespace Mufasa{
       }
 
       if(flags & Move::ENPASSANT){
-         int dpSq = history.back().doublePushSq;
-         nextState.epCaptured = mailbox[dpSq];
+         int dpSq = previous->doublePushSq;
          remPiece(mailbox[dpSq], dpSq);
       }
       
@@ -1327,14 +673,12 @@ namespace Mufasa{
       putPiece(after, to);
       
       nextState.previous = move;
+      nextState.moved = pieceIndex(after);
       
-      zobrist ^= history.back().zobristHash();
-      history.push_back(nextState);
-      zobrist ^= history.back().zobristHash();
-
-      repetitions[zobrist & 0x7FFFFF]++;
-
-      fillMoves();
+      zobrist ^= history[gamePly].zobristHash();
+      gamePly++;
+      zobrist ^= history[gamePly].zobristHash();
+      nextState.zobrist = zobrist;
 
       return true;
    }
@@ -1343,15 +687,13 @@ namespace Mufasa{
       int flags = move.getFlags();
       int from = move.start();
       int to = move.end();
-      
-      repetitions[zobrist & 0x7FFFFF]--;
 
       Piece after = mailbox[to]; // piece that ended up on target square
       Piece before = Piece();    // piece that was before on target square
       Piece original = after;    // piece that was originally moved (necessary for promotions)
       
-      BoardState prev = *(history.rbegin() + 1); 
-      before = history.back().captured;
+      const BoardState &prev = history[gamePly - 1]; 
+      before = history[gamePly].captured;
       
       if(flags & Move::CASTLING){
          int rookSq = (from - (from % 8));
@@ -1368,7 +710,7 @@ namespace Mufasa{
 
       if(flags & Move::ENPASSANT){
          int dpSq = prev.doublePushSq;
-         putPiece(history.back().epCaptured, dpSq);
+         putPiece(Piece(Figure::PAWN, ++prev.sideToMove), dpSq);
       }
       
       if(flags & Move::PROMOTION){
@@ -1379,9 +721,9 @@ namespace Mufasa{
       putPiece(before, to);
       putPiece(original, from);
       
-      zobrist ^= history.back().zobristHash();
-      history.pop_back();
-      zobrist ^= history.back().zobristHash();
+      // the key of the previous position is already known
+      gamePly--;
+      zobrist = history[gamePly].zobrist;
    }
 
    // naively assumes that the moves are correct
@@ -9,17 +9,20 @@
 #include "termcolor.hpp"
 
 #include<map>
-#include<deque>
 #include<vector>
 #include<string>
 #include<bitset>
 #include<cassert>
 #include<climits>
 #include<iostream>
+#include<algorithm>
 
 namespace Mufasa{
   
    const int oo = INT_MAX / 2;
+   const int MAX_PLY = 128;
+   const int MAX_HISTORY = 2048; // plies of the game and the search combined
+   const int MAX_HISTORY_SCORE = 16384; // bound of the history heuristic scores
 
    class Move{
       public:
@@ -43,10 +46,11 @@ namespace Mufasa{
       static const int target     = 0xFF00;
       static const int from       = 0xFF;
 
-      int score = 0;
-      int definition = 0;
+      // left uninitialized on purpose, so that move lists
+      // can be put on the stack without zeroing every slot
+      int definition;
       
-      Move(){}
+      Move() = default;
       Move(std::string algebraic);
       Move(int start, int end, int flags = 0);
       
@@ -61,82 +65,156 @@ namespace Mufasa{
 
    const Move nullmove{};
 
+   // Fixed capacity move container that lives on the stack
+   // No legal chess position has more than 218 moves, so 256 is plenty
+   class MoveList{
+      public:
+      static const int capacity = 256;
+
+      MoveList(){}
+      
+      MoveList(const MoveList &other){
+         *this = other;
+      }
+
+      MoveList& operator=(const MoveList &other){
+         count = other.count;
+         std::copy(other.begin(), other.end(), list);
+         return *this;
+      }
+
+      void push_back(Move move){
+         assert(count < capacity);
+         list[count++] = move;
+      }
+
+      void clear(){
+         count = 0;
+      }
+
+      size_t size() const{
+         return count;
+      }
+
+      bool empty() const{
+         return count == 0;
+      }
+
+      Move& operator[](size_t index){
+         return list[index];
+      }
+
+      const Move& operator[](size_t index) const{
+         return list[index];
+      }
+
+      Move* begin(){
+         return list;
+      }
+
+      Move* end(){
+         return list + count;
+      }
+
+      const Move* begin() const{
+         return list;
+      }
+
+      const Move* end() const{
+         return list + count;
+      }
+
+      private:
+      Move list[capacity];
+      size_t count = 0;
+   };
+
+   // Everything that can not be restored from the move itself during unmakeMove
+   // Kept compact so that a couple of states fit into a single cache line
    class BoardState{
       public:
-      Color sideToMove = Color::WHITE;
+      uint64_t zobrist = 0ULL; // full key of the position, restored on unmake
+      Move previous = nullmove;
+      
       Piece captured;
-      Piece epCaptured;
-      Move previous;
+      Color sideToMove = Color::WHITE;
 
       uint8_t castling = 0b0000; // KQkq; like in FEN string, first white, then black
-      int doublePushSq = -1;
-      int epTargetSq   = -1; 
-      int halfMoves    =  0;
-      int fullMoves    =  0;
+      int8_t doublePushSq = -1;
+      int8_t epTargetSq   = -1; 
+      int8_t moved        = -1; // piece now standing on the target of the previous move
+      int16_t halfMoves   =  0;
+      int16_t fullMoves   =  0;
 
       BoardState(){}
 
       uint64_t zobristHash();
    };
       
+   // Captures include en passant and every promotion, quiets are all the other moves
    enum GenType{
-      NONPROMOTION,
-      PROMOTION,
+      ALL,
       CAPTURE,
       QUIET
    };
    
+   // Restrictions on the moves of the side to move
+   struct MoveMasks{
+      uint64_t attacked;  // squares attacked by the enemy
+      uint64_t checkmask; // squares that resolve the check, all ones if there is none
+      uint64_t pinsHV;
+      uint64_t pinsD12;
+      int kingSq;
+   };
+
    struct Limits{
       uint64_t start;
       uint16_t depth;
       uint64_t wtime;
       uint64_t btime;
-      uint64_t alloc;
+      uint64_t winc = 0;
+      uint64_t binc = 0;
+      int movestogo = 0;  // zero when the whole game has to be played on the clock
+      uint64_t movetime = 0;
+      bool ponder = false; // time only starts to run with ponderhit
    };
    
-   enum EntryType{
-      EXACT,
-      LOWER,
-      UPPER
-   };
-
-
-   // Transposition Table Entry
-   struct TTEntry{
-       uint64_t key;
-       uint64_t age;
-       int depth;
-       int score;
-       Move move;
-       EntryType type;
-   };
-
    class Bitboard{
       public:
       
       Bitboard();
       int countFullMoves() const;
-      uint64_t countMoves() const;
       void set_position(std::string fen, std::vector<std::string> moves);
       Piece getPiece(int square) const;
-      BoardState getState() const;
+      const BoardState& getState(int back = 0) const;
+      int getGamePly() const;
       Color sideToMove() const;
       bool makeMove(Move move);
       void unmakeMove(Move move);
-      void pushMove(Move move);
-      void fillMoves();
-      void orderMoves(std::vector<Move> &moveList, const Move ttmove = nullmove);
+      void fillMoves(MoveList &moveList, GenType type = GenType::ALL);
+      uint64_t countLegal();
       
-      uint64_t zobristHash() const;
+      // defined in movegen.hpp
+      template<GenType type = GenType::ALL, typename Visitor>
+      void generateMoves(Visitor &visit);
+
+      template<Color us, GenType type, typename Visitor>
+      void generateMoves(Visitor &visit);
+      int scoreMove(const Move move) const;
+      
+      bool isCapture(const Move move) const;
+      bool isPseudoLegal(const Move move) const;
+      bool isLegal(const Move move);
+      bool isSquareAttacked(int square, Color by, uint64_t occupied) const;
+      uint64_t attackersTo(int square, uint64_t occupied) const;
+      int see(const Move move) const;
+      bool inCheck() const;
+      int countRepetitions() const;
       
-      void setDue(uint64_t due, uint64_t start);
-      const std::vector<Move> getMoves();
+      uint64_t zobristHash() const;
       
       int evaluate();
       int gamephase() const;
-      int quietSearch(int alpha, int beta);
-      std::pair<int, Move> negaMax(int depth, int alpha, int beta, std::vector<Move> &principle);
-      std::pair<int, Move> bestMove(int depth);
       
       Move moveFromUCI(std::string notation);
       
@@ -144,71 +222,49 @@ namespace Mufasa{
       void printBoard(std::ostream &os) const;
       
       private:
-      int nodes = 0;
-      int tthits = 0;
-      uint64_t age = 1;
       uint64_t zobrist = 0;
-      uint64_t duetime = 0; // due time we finish the search
-      uint64_t initime = 0;
-      
-      std::vector<TTEntry> tt;
-      std::vector<int8_t> repetitions;
 
-      Magics magics;
       Piece mailbox[64]; // useful for specific piece lookup
 
       uint64_t pieces[6][2];  // pieces and then color
       uint64_t occupancy[2];  // first white then black
       
-      uint64_t slidingAttacks[2];
-      uint64_t attacks[2];
-      
       uint64_t fullboard;
-      uint64_t checkmask;
-      uint64_t pinsD12;
-      uint64_t pinsHV;
+
+      // piece square sums from the white point of view and the game phase
+      // kept up to date by putPiece and remPiece
+      int psqtMG = 0;
+      int psqtEG = 0;
+      int phase = 0;
       
       void clearBoard();
 
       void remPiece(Piece piece, int square);
       void putPiece(Piece piece, int square);
       
-      void fillKingAttacks(Color side);
-      void fillPawnAttacks(Color side);
-      void fillRookAttacks(Color side);
-      void fillKnightAttacks(Color side);
-      void fillBishopAttacks(Color side);
-      void fillQueenAttacks(Color side);
+      template<Color us>
+      uint64_t enemyAttacks(int kingSq) const;
 
-      void fillAttackMask(Color side);
-      void fillCheckMask();
-      void fillPinMask();
+      template<Color us>
+      MoveMasks getMasks() const;
 
-      // sliding pieces move generation
-      void singleBishopMoves(int square);
-      void fillBishopMoves();
+      template<Color us, GenType type>
+      uint64_t targetSquares() const;
 
-      void singleRookMoves(int square);
-      void fillRookMoves();
+      template<Color us, GenType type, typename Visitor>
+      void fillSliderMoves(const MoveMasks &masks, Visitor &visit);
 
-      void fillKingMoves();
-      void fillQueenMoves();
-      
-      // pawn move generation
-      void singleWhitePawnTargets(int square);
-      void singleBlackPawnTargets(int square);
+      template<Color us, GenType type, typename Visitor>
+      void fillKnightMoves(const MoveMasks &masks, Visitor &visit);
 
-      template<GenType type>
-      void fillWhitePawnMoves();
+      template<Color us, GenType type, typename Visitor>
+      void fillPawnMoves(const MoveMasks &masks, Visitor &visit);
 
-      template<GenType type>
-      void fillBlackPawnMoves();
-      
-      void fillPawnMoves();
-      void fillKnightMoves();
+      template<Color us, GenType type, typename Visitor>
+      void fillKingMoves(const MoveMasks &masks, Visitor &visit);
 
-      std::vector<Move> moves;
-      std::deque<BoardState> history;
+      int gamePly = 0; // index of the current state in history
+      BoardState history[MAX_HISTORY];
    };
 }
 
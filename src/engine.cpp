@@ -1,88 +1,341 @@
 #include "engine.hpp"
+#include "movegen.hpp"
 
 namespace Mufasa{
    
-   Engine::Engine(){}
+   Engine::Engine(){
+      Magics::init();
+      setThreads(1);
+   }
    
+   Engine::~Engine(){
+      stop();
+   }
+
+   void Engine::go(Limits limits){
+      wait();
+      stopFlag = false;
+      infinite = !limits.depth && !limits.movetime && !(getPlayer() == Color::WHITE ? limits.wtime : limits.btime);
+      pondering = limits.ponder;
+      worker = std::thread([this, limits]{ search(limits); });
+   }
+
+   void Engine::bestMove(Limits limits){
+      wait();
+      stopFlag = false;
+      pondering = limits.ponder;
+      search(limits);
+   }
+
+   // the search notices the flag at its next node and still reports its best move
    void Engine::stop(){
+      stopFlag = true;
+      wait();
+   }
+
+   void Engine::wait(){
+      if(worker.joinable()) worker.join();
    }
 
+   void Engine::finish(){
+      if(pondering || infinite) stop();
+      else wait();
+   }
+
+   void Engine::ponderhit(){
+      std::lock_guard<std::mutex> lock(ponderMutex);
+      if(!pondering) return;
+
+      timeManager.start(now());
+      for(auto &searcher : searchers){
+         searcher->setDeadline(timeManager.deadline());
+      }
+
+      pondering = false;
+   }
+
+   // nothing the search reads may change while it runs
    void Engine::set_position(std::string fen, std::vector<std::string> moves){
+      wait();
       board.set_position(fen, moves);
    }
 
-   void Engine::bestMove(Limits limits){
+   void Engine::setHash(size_t megabytes){
+      wait();
+      TT.resize(megabytes);
+   }
+
+   void Engine::clearHash(){
+      wait();
+      TT.clear();
+   }
+
+   // searchers are kept when the pool grows, so that their move ordering tables stay warm
+   // Every one is created by a thread bound to its node, so that its tables live there
+   void Engine::setThreads(int threads){
+      wait();
+      threads = std::clamp(threads, 1, MAX_THREADS);
+
+      while((int)searchers.size() > threads) searchers.pop_back();
+      while((int)searchers.size() < threads){
+         const int id = searchers.size();
+         std::unique_ptr<Searcher> searcher;
+
+         std::thread([&]{
+            bindThread(id);
+            searcher = std::make_unique<Searcher>(id, stopFlag, searchers);
+         }).join();
+
+         searchers.push_back(std::move(searcher));
+      }
+   }
+
+   void Engine::setBinding(bool bind){
+      wait();
+      bindThreads = bind;
+   }
+
+   void Engine::bindThread(int id) const{
+      if(bindThreads) Numa::bindThread(id);
+      else Numa::unbindThread();
+   }
+
+   void Engine::search(Limits limits){
       int depth = limits.depth;
-      int player = getPlayer();
-      int gamephase = board.gamephase();
-      int fullmoves = board.countFullMoves();
-      
-      uint64_t duetime = limits.start;
-      uint64_t accessible = 0;
-      
-      if(player == Color::WHITE){
-         accessible = limits.wtime;
+
+      // if the depth limit is zero then we go infinite depth
+      if(!depth) depth = 100;
+
+      TT.newSearch();
+
+      {
+         // a ponderhit arriving before this point finds the search not pondering anymore
+         std::lock_guard<std::mutex> lock(ponderMutex);
+         timeManager.init(limits, getPlayer(), board.gamephase());
+         if(!pondering) timeManager.start(limits.start);
+
+         // nothing to think about, the first iteration only finds the move to ponder on
+         if(timeManager.getSoft() && board.countLegal() == 1) depth = 1;
+
+         for(auto &searcher : searchers){
+            searcher->setPosition(board);
+            searcher->setDue(timeManager.deadline(), limits.start);
+         }
       }
-      else{
-         accessible = limits.btime;
+
+      std::vector<std::thread> helpers;
+      for(size_t i = 1; i < searchers.size(); i++){
+         helpers.emplace_back([this, i, depth]{
+            bindThread(i);
+            searchers[i]->bestMove(depth);
+         });
       }
-      
-      uint64_t upperlimit = accessible / 5;
-      uint64_t lowerlimit = 100ULL;
 
-      // if the limit is zero then there is no limit
-      if(accessible){
-         accessible *= gamephase;
-         accessible *= fullmoves;
-         accessible /= 24;
-         accessible /= 120;
+      bindThread(0);
+      searchers[0]->bestMove(depth, &timeManager);
 
-         accessible = std::min(upperlimit, accessible);
-         accessible = std::max(lowerlimit, accessible);
+      // the best move may only be reported once the opponent has moved
+      while(pondering && !stopFlag){
+         std::this_thread::sleep_for(std::chrono::milliseconds(1));
       }
-      else accessible = 3600000ULL;
-      
-      // if the depth limit is zero then we go infinite depth
-      if(!depth) depth = 100;
 
-      duetime += accessible;
-      board.setDue(duetime, limits.start);
+      // helpers only stop once the main thread is done
+      stopFlag = true;
+      for(auto &helper : helpers) helper.join();
+
+      const Searcher &best = voteBestMove();
+      Move ponder = ponderMove(best);
+
+      // written at once, so that it does not interleave with replies of the UCI thread
+      std::ostringstream reply;
+      reply << "bestmove " << best.completedMove;
+      if(!(ponder == nullmove)) reply << " ponder " << ponder;
+      reply << "\n";
+      std::cout << reply.str() << std::flush;
+   }
+
+   // the variation may be cut short by a TT hit, then the table is asked for the reply
+   Move Engine::ponderMove(const Searcher &searcher){
+      if(searcher.completedMove == nullmove) return nullmove;
+      if(!(searcher.completedPonder == nullmove)) return searcher.completedPonder;
+
+      Bitboard after = board;
+      after.makeMove(searcher.completedMove);
+
+      TTData tthit;
+      if(TT.probe(after.zobristHash(), tthit) && !(tthit.move == nullmove) && after.isLegal(tthit.move)){
+         return tthit.move;
+      }
+
+      return nullmove;
+   }
+
+   // Every thread votes for the move of its last finished iteration,
+   // deeper iterations and better scores weigh more
+   const Searcher& Engine::voteBestMove() const{
+      const Searcher* main = searchers[0].get();
+      if(searchers.size() == 1 || !main->completedDepth) return *main;
+
+      int64_t minScore = main->completedScore;
+      for(const auto &searcher : searchers){
+         if(searcher->completedDepth) minScore = std::min<int64_t>(minScore, searcher->completedScore);
+      }
+
+      auto weight = [minScore](const Searcher &searcher){
+         return (searcher.completedScore - minScore + 14) * searcher.completedDepth;
+      };
 
-      auto [score, move] = board.bestMove(depth);
+      const Searcher* best = main;
+      int64_t bestVotes = 0;
+
+      for(const auto &candidate : searchers){
+         if(!candidate->completedDepth) continue;
+
+         int64_t votes = 0;
+         for(const auto &voter : searchers){
+            if(voter->completedDepth && voter->completedMove == candidate->completedMove){
+               votes += weight(*voter);
+            }
+         }
+
+         if(votes > bestVotes || (votes == bestVotes && candidate->completedDepth > best->completedDepth)){
+            best = candidate.get();
+            bestVotes = votes;
+         }
+      }
+
+      return *best;
+   }
+   
+   // Moves are consumed straight from the generator, nothing is stored
+   uint64_t Engine::countNodes(Bitboard &board, int depth, PerftTable *table, PerftStats &stats){
+      uint64_t nodes = 0;
       
-      std::cout << "bestmove " << move << std::endl;
+      // bulk counting, leaves are never visited
+      if(depth == 1){
+         return board.countLegal();
+      }
+
+      if(table){
+         stats.probes++;
+         if(table->probe(board.zobristHash(), depth, nodes)){
+            stats.hits++;
+            return nodes;
+         }
+      }
+
+      auto visit = [&](const Move play){
+         board.makeMove(play);
+         nodes += countNodes(board, depth - 1, table, stats);
+         board.unmakeMove(play);
+      };
+
+      board.generateMoves(visit);
+
+      if(table) table->store(board.zobristHash(), depth, nodes);
+
+      return nodes;
    }
    
-   uint64_t Engine::perft(int depth, int root){
+   // Root moves are handed out to worker threads, each with its own copy of the board
+   // With several threads the work is split one ply deeper, 
+   // so that positions with only a few root moves still keep every thread busy
+   //
+   // With a nonzero hash size (in megabytes) subtrees reached by transpositions
+   // are counted only once, the table is shared by all threads
+   uint64_t Engine::perft(int depth, int threads, size_t hash){
+      wait();
       if(depth == 0) return 0;
 
-      if(depth == root){
-         board.fillMoves();
+      MoveList moves;
+      board.fillMoves(moves);
+      
+      if(depth == 1){
+         for(const auto &play : moves){
+            std::cout << play << ": 1" << std::endl;
+         }
+         return moves.size();
       }
+      
+      // pairs of root move index and reply, nullmove reply stands for the whole subtree
+      std::vector<std::pair<size_t, Move>> work;
+
+      for(size_t i = 0; i < moves.size(); i++){
+         if(threads > 1 && depth > 2){
+            MoveList replies;
+            
+            board.makeMove(moves[i]);
+            board.fillMoves(replies);
+            board.unmakeMove(moves[i]);
+
+            for(const auto &reply : replies){
+               work.push_back({i, reply});
+            }
+         }
+         else work.push_back({i, nullmove});
+      }
+
+      std::vector<uint64_t> counts(work.size(), 0);
+      std::atomic<size_t> next{0};
 
-      std::vector<Move> moves = board.getMoves();
+      std::unique_ptr<PerftTable> table;
+      if(hash) table = std::make_unique<PerftTable>(hash);
       
-      if(depth == 1){
-         if(depth == root){
-            for(const auto &play : moves){
-               std::cout << play << ": 1" << std::endl;
+      std::vector<PerftStats> stats(threads);
+
+      auto worker = [&](int id){
+         Bitboard local = board;
+         size_t job;
+
+         while((job = next++) < work.size()){
+            auto [index, reply] = work[job];
+            
+            local.makeMove(moves[index]);
+            if(reply == nullmove){
+               counts[job] = countNodes(local, depth - 1, table.get(), stats[id]);
+            }
+            else{
+               local.makeMove(reply);
+               counts[job] = countNodes(local, depth - 2, table.get(), stats[id]);
+               local.unmakeMove(reply);
             }
+            local.unmakeMove(moves[index]);
          }
-         return board.countMoves();
+      };
+      
+      std::vector<std::thread> pool;
+      for(int i = 1; i < threads; i++){
+         pool.emplace_back(worker, i);
+      }
+
+      worker(0);
+
+      for(auto &thread : pool){
+         thread.join();
+      }
+
+      std::vector<uint64_t> divide(moves.size(), 0);
+      for(size_t job = 0; job < work.size(); job++){
+         divide[work[job].first] += counts[job];
       }
 
       uint64_t nodes = 0;
       
-      for(const auto &play : moves){
-         board.makeMove(play);
+      for(size_t i = 0; i < moves.size(); i++){
+         std::cout << moves[i] << ": " << divide[i] << std::endl;
+         nodes += divide[i];
+      }
 
-         uint64_t add = perft(depth - 1, root);
-         if(depth == root){
-            std::cout << play << ": " << add << std::endl;
+      if(table){
+         PerftStats total;
+         for(const auto &part : stats){
+            total.probes += part.probes;
+            total.hits += part.hits;
          }
 
-         nodes += add;
-         board.unmakeMove(play);
+         double rate = total.probes ? (100.0 * total.hits / total.probes) : 0.0;
+         std::cout << std::endl << "Hash hits: " << total.hits << " of " << total.probes;
+         std::cout << " probes (" << rate << "%)" << std::endl;
       }
 
       return nodes;
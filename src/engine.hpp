@@ -2,29 +2,80 @@
 #define ENGINE_HPP_INCLUDED
 
 #include "bitboard.hpp"
+#include "search.hpp"
+#include "timeman.hpp"
+#include "numa.hpp"
+#include "tt.hpp"
 
 #include <vector>
 #include <string>
+#include <sstream>
+#include <thread>
+#include <atomic>
+#include <mutex>
 #include <deque>
 #include <map>
 
 namespace Mufasa{
+   const int MAX_THREADS = 256;
+
    class Engine{
       public:
          Engine();
+         ~Engine();
+
+         // go returns at once and the search prints bestmove from its own thread,
+         // bestMove blocks until the search is over
+         void go(Limits limits);
+         void bestMove(Limits limits);
          void stop();
+         void wait();
+
+         // no more commands will come, searches bound by depth or time may still finish,
+         // ones waiting for stop or ponderhit are stopped
+         void finish();
+
+         // the expected move was played, the clock of the search starts running
+         void ponderhit();
+
          void set_position(std::string fen, std::vector<std::string> moves = {});
          
+         void setHash(size_t megabytes);
+         void clearHash();
+         void setThreads(int threads);
+         void setBinding(bool bind);
+         
          Color getPlayer();
-         void bestMove(Limits limits);
          
-         uint64_t perft(int depth, int root);
+         uint64_t perft(int depth, int threads = 1, size_t hash = 0);
          void printBoard(std::ostream &os);
       
       private:
-         bool stopFlag = false;
+         std::atomic<bool> stopFlag{false};
+         std::thread worker;
          
          Bitboard board;
+
+         // Lazy SMP, the first searcher runs on the thread of the search and reports the progress
+         Searcher::Pool searchers;
+         void search(Limits limits);
+         const Searcher& voteBestMove() const;
+         Move ponderMove(const Searcher &searcher);
+
+         // the last search has neither a depth nor a time limit, set by the UCI thread only
+         bool infinite = false;
+
+         // while pondering the search has no due time and never reports on its own
+         std::atomic<bool> pondering{false};
+         std::mutex ponderMutex; // orders ponderhit with setting up the due time
+
+         TimeManager timeManager;
+
+         // search threads stay on their NUMA node, only matters with more than one node
+         bool bindThreads = true;
+         void bindThread(int id) const;
+
+         static uint64_t countNodes(Bitboard &board, int depth, PerftTable *table, PerftStats &stats);
    };
 }
 
@@ -2,86 +2,82 @@
 #define MAGICS_HPP_INCLUDED
 
 #include "misc.hpp"
+#include "tables.hpp"
 
-#include<random>
-#include<vector>
+#include<mutex>
 #include<iostream>
 
 namespace Mufasa{
 
-   struct MagicEntry{
-      uint64_t mask;
-      uint64_t magic;
-      int shift; 
-   };
-   
    class Magics{
       public:
-      inline static uint64_t wpawnPushes[64];
-      inline static uint64_t bpawnPushes[64];
+      inline static constexpr SquareTable wpawnPushes = stepTable(wpawnPushSteps);
+      inline static constexpr SquareTable bpawnPushes = stepTable(bpawnPushSteps);
 
-      inline static uint64_t wpawnAttacks[64];
-      inline static uint64_t bpawnAttacks[64];
+      inline static constexpr SquareTable wpawnAttacks = stepTable(wpawnAttackSteps);
+      inline static constexpr SquareTable bpawnAttacks = stepTable(bpawnAttackSteps);
       
-      inline static uint64_t knightMoves[64];
-      inline static uint64_t kingMoves[64];
-      inline static uint64_t rays[8][64];
+      inline static constexpr SquareTable knightMoves = stepTable(knightSteps);
+      inline static constexpr SquareTable kingMoves = stepTable(kingSteps);
+      inline static constexpr RayTable rays = rayTable();
+      inline static constexpr SquareTable bishopRays = raysUnionTable(rays, 0);
+      inline static constexpr SquareTable rookRays = raysUnionTable(rays, 4);
 
-      // ensures to scan at least an outer square if the occupied board is empty
-      inline static uint64_t rayBit[8]; 
-      inline static uint64_t leftHalf[64];
-      inline static uint64_t rightHalf[64];
+      inline static constexpr SquareTable leftHalf = leftHalfTable();
+      inline static constexpr SquareTable rightHalf = rightHalfTable();
 
       // returns a line bitmask that goes through two squares
       // if they are diagonal, on the same file, or rank
-      inline static uint64_t connect[64][64];
+      inline static constexpr PairTable connect = connectTable(rays);
       
       // returns a bitmask that connects exclusively squares
       // between two specified squares
-      inline static uint64_t flesh[64][64];
+      inline static constexpr PairTable flesh = fleshTable(rays);
       
       // pseudorandom numbers required for zobrist hashing
-      inline static uint64_t zobristPieces[6][64];
-      inline static uint64_t zobristCastle[16];
-      inline static uint64_t zobristEpFile[8];
-      inline static uint64_t zobristBlack;
+      inline static constexpr ZobristPieceTable zobristPieces = zobristPieceTable();
+      inline static constexpr std::array<uint64_t, 16> zobristCastle = zobristKeys<16>(768);
+      inline static constexpr std::array<uint64_t, 8> zobristEpFile = zobristKeys<8>(784);
+      inline static constexpr uint64_t zobristBlack = zobristKey(792);
 
-      Magics();
+      // fills the slider attack tables, has to run once per process
+      // before any attacks are looked up, later calls return immediately
+      static void init();
       
       static uint64_t getPositiveRayAttacks(uint64_t occupied, int dir, int sq);
       static uint64_t getNegativeRayAttacks(uint64_t occupied, int dir, int sq);
       
-      static uint64_t getBishopAttacks(uint64_t occupied, int sq);
-      static uint64_t getRookAttacks(uint64_t occupied, int sq);
+      static uint64_t getBishopAttacks(uint64_t occupied, int sq){
+         return sliderAttacks[sliderIndex(occupied, bishopMagics[sq])];
+      }
+
+      static uint64_t getRookAttacks(uint64_t occupied, int sq){
+         return sliderAttacks[sliderIndex(occupied, rookMagics[sq])];
+      }
 
       static uint64_t getXRayRookAttacks(uint64_t occupied, uint64_t blockers, int sq);
       static uint64_t getXRayBishopAttacks(uint64_t occupied, uint64_t blockers, int sq);
       
       private:
       
-      inline static MagicEntry bishopMagics[64];
-      inline static MagicEntry rookMagics[64];
-
-      inline static std::vector<std::vector<uint64_t>> bishopAttacks;
-      inline static std::vector<std::vector<uint64_t>> rookAttacks;
+      // With USE_PEXT only the masks are used, the index is the
+      // occupancy compressed by the mask
+      inline static constexpr MagicTable bishopMagics = magicTable(bishopMagicNumbers, 0, 0);
+      inline static constexpr MagicTable rookMagics = magicTable(rookMagicNumbers, 4, magicTableEnd(bishopMagics));
 
-      inline static void calcWhitePawnPushes();
-      inline static void calcWhitePawnAttacks();
-      inline static void calcBlackPawnPushes();
-      inline static void calcBlackPawnAttacks();
+      // bishop squares followed by rook squares, 5248 + 102400 entries
+      inline static std::once_flag initFlag;
+      alignas(64) inline static uint64_t sliderAttacks[magicTableEnd(rookMagics)];
 
-      inline static void calcKnightMoves();
-      inline static void calcKingMoves();
-      inline static void calcHalves();
-      inline static void calcFlesh();
-      inline static void calcLines();
-      inline static void calcRays();
-      
-      inline static void generateMagics();
-      inline static bool isBishopMagicValid(MagicEntry entry, int square);
-      inline static bool isRookMagicValid(MagicEntry entry, int square);
+      static uint64_t sliderIndex(uint64_t occupied, const MagicEntry& entry){
+#ifdef USE_PEXT
+         return entry.offset + pext(occupied, entry.mask);
+#else
+         return entry.offset + (((occupied & entry.mask) * entry.magic) >> entry.shift);
+#endif
+      }
 
-      inline static void fillZobristNumbers();
+      inline static void fillSliderAttacks();
    };
 
 }
@@ -1,10 +1,19 @@
 #ifndef MISC_HPP_INCLUDED
 #define MISC_HPP_INCLUDED
 
+#ifdef USE_PEXT
+#include<immintrin.h>
+#endif
+
+#ifdef __SSE2__
+#include<emmintrin.h>
+#endif
+
 #include<bitset>
 #include<string>
 #include<chrono>
 #include<cassert>
+#include<climits>
 #include<iostream>
 #include<algorithm>
 
@@ -59,6 +68,46 @@ namespace Mufasa{
       return __builtin_popcountll(bb);
    }
 
+   // gathers the bits of bb selected by the mask into the low bits
+   inline uint64_t pext(uint64_t bb, uint64_t mask){
+#ifdef USE_PEXT
+      return _pext_u64(bb, mask);
+#else
+      uint64_t result = 0ULL;
+      for(uint64_t bit = 1ULL; mask != 0ULL; bit <<= 1){
+         if(bb & mask & -mask) result |= bit;
+         mask &= (mask - 1);
+      }
+      return result;
+#endif
+   }
+
+   // index of the first largest value in [first, last), which must not be empty
+   inline size_t maxIndex(const int* values, size_t first, size_t last){
+      int best = INT_MIN;
+      size_t i = first;
+#ifdef __SSE2__
+      // four lanes at a time, SSE2 has no signed max so it is built from a compare
+      if(last - first >= 8){
+         __m128i top = _mm_set1_epi32(INT_MIN);
+         for(; i + 4 <= last; i += 4){
+            __m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+            __m128i greater = _mm_cmpgt_epi32(next, top);
+            top = _mm_or_si128(_mm_and_si128(greater, next), _mm_andnot_si128(greater, top));
+         }
+
+         int lanes[4];
+         _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), top);
+         best = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+      }
+#endif
+      for(; i < last; i++) best = std::max(best, values[i]);
+
+      size_t index = first;
+      while(values[index] != best) index++;
+      return index;
+   }
+
    void popMSB(uint64_t& bb);
    void popLSB(uint64_t& bb);
    
@@ -70,8 +119,9 @@ namespace Mufasa{
 
    int flip (int square);
    
+   // milliseconds on a clock that never jumps, only differences are meaningful
    inline uint64_t now(){
-      return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+      return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
    }
 
    std::string toAlgebraic(int square);
@@ -0,0 +1,443 @@
+#ifndef MOVEGEN_HPP_INCLUDED
+#define MOVEGEN_HPP_INCLUDED
+
+#include "bitboard.hpp"
+
+#include<type_traits>
+
+// Legal move generator specialized at compile time for the side to move
+// in the spirit of Gigantua: https://github.com/Gigantua/Gigantua
+//
+// Moves are not stored anywhere, every legal move is handed to the visitor
+// which is any callable accepting a Move, e.g. visit(Move(from, to))
+//
+// The visitor is free to make and unmake the move it receives,
+// all the masks generation depends on are kept in local variables
+//
+// A MoveCounter visitor is recognised at compile time, whole target
+// sets are then counted with popCount instead of being visited
+
+namespace Mufasa{
+
+   const uint64_t skipAfile = 0xFEFEFEFEFEFEFEFEULL;
+   const uint64_t skipHfile = 0x7F7F7F7F7F7F7F7FULL;
+
+   // Pawn shifts from the point of view of the side to move
+   // left captures go towards the A file, right captures towards the H file
+   template<Color us>
+   constexpr int pawnForward(){
+      return (us == Color::WHITE) ? 8 : -8;
+   }
+
+   template<Color us>
+   constexpr int pawnLeft(){
+      return (us == Color::WHITE) ? 7 : -9;
+   }
+
+   template<Color us>
+   constexpr int pawnRight(){
+      return (us == Color::WHITE) ? 9 : -7;
+   }
+
+   template<int offset>
+   constexpr uint64_t shiftBy(uint64_t bb){
+      if constexpr (offset > 0) return (bb << offset);
+      else return (bb >> (-offset));
+   }
+
+   struct MoveCounter{
+      uint64_t count = 0;
+
+      void operator()(const Move&){
+         count++;
+      }
+   };
+
+   template<typename Visitor>
+   constexpr bool isCounter = std::is_same_v<Visitor, MoveCounter>;
+
+   // every target is reached from the same square
+   template<typename Visitor>
+   inline void visitTargets(Visitor &visit, int from, uint64_t targets){
+      if constexpr (isCounter<Visitor>){
+         visit.count += popCount(targets);
+      }
+      else{
+         while(targets != 0ULL){
+            int to = bitScanPop(targets);
+            visit(Move(from, to));
+         }
+      }
+   }
+
+   // every target is reached from the square offset behind it
+   template<int offset, typename Visitor>
+   inline void visitPawnTargets(Visitor &visit, uint64_t targets, int flags){
+      if constexpr (isCounter<Visitor>){
+         visit.count += popCount(targets);
+      }
+      else{
+         while(targets != 0ULL){
+            int to = bitScanPop(targets);
+            visit(Move(to - offset, to, flags));
+         }
+      }
+   }
+
+   template<int offset, typename Visitor>
+   inline void visitPromotionTargets(Visitor &visit, uint64_t targets, int flags){
+      if constexpr (isCounter<Visitor>){
+         visit.count += 4 * popCount(targets);
+      }
+      else{
+         while(targets != 0ULL){
+            int to = bitScanPop(targets);
+            int from = to - offset;
+            visit(Move(from, to, flags | Move::PROMOTION | Move::TOQUEEN));
+            visit(Move(from, to, flags | Move::PROMOTION | Move::TOROOK));
+            visit(Move(from, to, flags | Move::PROMOTION | Move::TOBISHOP));
+            visit(Move(from, to, flags | Move::PROMOTION | Move::TOKNIGHT));
+         }
+      }
+   }
+
+   template<Color us, GenType type, typename Visitor>
+   void Bitboard::generateMoves(Visitor &visit){
+      MoveMasks masks = getMasks<us>();
+
+      // only the king can move out of a double check
+      if(masks.checkmask != 0ULL){
+         fillSliderMoves<us, type>(masks, visit);
+         fillKnightMoves<us, type>(masks, visit);
+         fillPawnMoves<us, type>(masks, visit);
+      }
+
+      fillKingMoves<us, type>(masks, visit);
+   }
+
+   template<GenType type, typename Visitor>
+   void Bitboard::generateMoves(Visitor &visit){
+      if(sideToMove() == Color::WHITE){
+         generateMoves<Color::WHITE, type>(visit);
+      }
+      else{
+         generateMoves<Color::BLACK, type>(visit);
+      }
+   }
+
+   // squares pieces other than pawns may move to
+   template<Color us, GenType type>
+   inline uint64_t Bitboard::targetSquares() const{
+      constexpr Color them = (us == Color::WHITE) ? Color::BLACK : Color::WHITE;
+
+      if constexpr (type == GenType::CAPTURE) return occupancy[them];
+      else if constexpr (type == GenType::QUIET) return ~fullboard;
+      else return ~occupancy[us];
+   }
+
+   // Squares attacked by the enemy, sliders see through our king
+   // so that the king can not step back along the line of the check
+   template<Color us>
+   uint64_t Bitboard::enemyAttacks(int kingSq) const{
+      constexpr Color them = (us == Color::WHITE) ? Color::BLACK : Color::WHITE;
+
+      const int pawn = Figure::PAWN - 1;
+      const int knight = Figure::KNIGHT - 1;
+      const int bishop = Figure::BISHOP - 1;
+      const int rook = Figure::ROOK - 1;
+      const int queen = Figure::QUEEN - 1;
+      const int king = Figure::KING - 1;
+
+      const uint64_t occupied = fullboard ^ (1ULL << kingSq);
+
+      uint64_t attacked = Magics::kingMoves[bitScan(pieces[king][them])];
+
+      uint64_t pawns = pieces[pawn][them];
+      attacked |= shiftBy<pawnLeft<them>()>(pawns & skipAfile);
+      attacked |= shiftBy<pawnRight<them>()>(pawns & skipHfile);
+
+      uint64_t knights = pieces[knight][them];
+      while(knights != 0ULL){
+         attacked |= Magics::knightMoves[bitScanPop(knights)];
+      }
+
+      uint64_t diagonals = pieces[bishop][them] | pieces[queen][them];
+      while(diagonals != 0ULL){
+         attacked |= Magics::getBishopAttacks(occupied, bitScanPop(diagonals));
+      }
+
+      uint64_t orthogonals = pieces[rook][them] | pieces[queen][them];
+      while(orthogonals != 0ULL){
+         attacked |= Magics::getRookAttacks(occupied, bitScanPop(orthogonals));
+      }
+
+      return attacked;
+   }
+
+   template<Color us>
+   MoveMasks Bitboard::getMasks() const{
+      constexpr Color them = (us == Color::WHITE) ? Color::BLACK : Color::WHITE;
+
+      const int king = Figure::KING - 1;
+      const int pawn = Figure::PAWN - 1;
+      const int knight = Figure::KNIGHT - 1;
+      const int bishop = Figure::BISHOP - 1;
+      const int rook = Figure::ROOK - 1;
+      const int queen = Figure::QUEEN - 1;
+
+      if(pieces[king][us] == 0ULL){
+         std::cout << "ERROR: " << std::endl;
+         for(int i = 1; i <= gamePly; i++){
+            std::cout << history[i].previous << " ";
+         }
+         std::cout << std::endl;
+      }
+
+      assert(pieces[king][us] != 0ULL);
+
+      MoveMasks masks;
+
+      const int sq = bitScan(pieces[king][us]);
+      const uint64_t kingbit = (1ULL << sq);
+
+      masks.kingSq = sq;
+      masks.attacked = enemyAttacks<us>(sq);
+
+      const uint64_t opBQ = pieces[bishop][them] | pieces[queen][them];
+      const uint64_t opRQ = pieces[rook][them] | pieces[queen][them];
+
+      // check mask, squares that either capture the checking piece or block the check
+      // the checkers are only looked for when the king stands on an attacked square
+      masks.checkmask = -1;
+
+      if(masks.attacked & kingbit){
+         const uint64_t pawnAttacks = (us == Color::WHITE) ? Magics::wpawnAttacks[sq] : Magics::bpawnAttacks[sq];
+
+         uint64_t checkers = (Magics::getBishopAttacks(fullboard, sq) & opBQ)
+                           | (Magics::getRookAttacks(fullboard, sq) & opRQ)
+                           | (Magics::knightMoves[sq] & pieces[knight][them])
+                           | (pawnAttacks & pieces[pawn][them]);
+
+         if(popCount(checkers) > 1) masks.checkmask = 0ULL;
+         else masks.checkmask = Magics::flesh[sq][bitScan(checkers)] | checkers;
+      }
+
+      // pin masks, pieces between our king and an enemy slider
+      // nothing can be pinned along lines no enemy slider stands on
+      masks.pinsHV = 0ULL;
+      masks.pinsD12 = 0ULL;
+
+      if(Magics::bishopRays[sq] & opBQ){
+         uint64_t pinners = Magics::getXRayBishopAttacks(fullboard, occupancy[us], sq) & opBQ;
+         while(pinners != 0ULL){
+            int enemy = bitScanPop(pinners);
+            masks.pinsD12 |= Magics::flesh[sq][enemy] & fullboard;
+         }
+      }
+
+      if(Magics::rookRays[sq] & opRQ){
+         uint64_t pinners = Magics::getXRayRookAttacks(fullboard, occupancy[us], sq) & opRQ;
+         while(pinners != 0ULL){
+            int enemy = bitScanPop(pinners);
+            masks.pinsHV |= Magics::flesh[sq][enemy] & fullboard;
+         }
+      }
+
+      return masks;
+   }
+
+   // Queens are handled both as bishops and as rooks
+   template<Color us, GenType type, typename Visitor>
+   void Bitboard::fillSliderMoves(const MoveMasks &masks, Visitor &visit){
+      const int bishop = Figure::BISHOP - 1;
+      const int rook = Figure::ROOK - 1;
+      const int queen = Figure::QUEEN - 1;
+
+      const uint64_t movable = targetSquares<us, type>() & masks.checkmask;
+
+      // pieces pinned orthogonally can not move diagonally and vice versa
+      uint64_t diagonals = (pieces[bishop][us] | pieces[queen][us]) & ~masks.pinsHV;
+
+      while(diagonals != 0ULL){
+         int sq = bitScanPop(diagonals);
+         uint64_t legals = Magics::getBishopAttacks(fullboard, sq) & movable;
+
+         if((1ULL << sq) & masks.pinsD12){
+            legals &= Magics::connect[sq][masks.kingSq];
+         }
+
+         visitTargets(visit, sq, legals);
+      }
+
+      uint64_t orthogonals = (pieces[rook][us] | pieces[queen][us]) & ~masks.pinsD12;
+
+      while(orthogonals != 0ULL){
+         int sq = bitScanPop(orthogonals);
+         uint64_t legals = Magics::getRookAttacks(fullboard, sq) & movable;
+
+         if((1ULL << sq) & masks.pinsHV){
+            legals &= Magics::connect[sq][masks.kingSq];
+         }
+
+         visitTargets(visit, sq, legals);
+      }
+   }
+
+   template<Color us, GenType type, typename Visitor>
+   void Bitboard::fillKnightMoves(const MoveMasks &masks, Visitor &visit){
+      const int knight = Figure::KNIGHT - 1;
+
+      // pinned knights can never move
+      uint64_t knights = pieces[knight][us] & ~(masks.pinsHV | masks.pinsD12);
+
+      while(knights != 0ULL){
+         int sq = bitScanPop(knights);
+         uint64_t targets = Magics::knightMoves[sq] & targetSquares<us, type>() & masks.checkmask;
+         visitTargets(visit, sq, targets);
+      }
+   }
+
+   template<Color us, GenType type, typename Visitor>
+   void Bitboard::fillPawnMoves(const MoveMasks &masks, Visitor &visit){
+      constexpr Color them = (us == Color::WHITE) ? Color::BLACK : Color::WHITE;
+      constexpr int forward = pawnForward<us>();
+      constexpr int left = pawnLeft<us>();
+      constexpr int right = pawnRight<us>();
+
+      const int pawn = Figure::PAWN - 1;
+      const int rook = Figure::ROOK - 1;
+      const int queen = Figure::QUEEN - 1;
+
+      const int kingsq = masks.kingSq;
+      const uint64_t checkmask = masks.checkmask;
+      const uint64_t pinsHV = masks.pinsHV;
+      const uint64_t pinsD12 = masks.pinsD12;
+
+      // rank before promotion and rank after double push
+      constexpr uint64_t lastRank = (us == Color::WHITE) ? 0x00FF000000000000ULL : 0x000000000000FF00ULL;
+      constexpr uint64_t pushRank = (us == Color::WHITE) ? 0x00000000FF000000ULL : 0x000000FF00000000ULL;
+
+      const uint64_t pawns = pieces[pawn][us];
+
+      // pawns pinned orthogonally can only push if they are on the same file as the king
+      const uint64_t pushable = pawns & ~pinsD12
+      & ~(pinsHV & (Magics::rightHalf[kingsq] | Magics::leftHalf[kingsq]));
+
+      // pawns pinned diagonally can only capture in the direction away from the king
+      // (from the white player point of view)
+      // left captures go north west, so they are only available for pawns north west or south east from the king
+      // right captures go north east, so they are only available for pawns south west or north east from the king
+      //
+      // for black the directions are mirrored
+      const uint64_t leftPinned  = (us == Color::WHITE) ? (Magics::rays[1][kingsq] | Magics::rays[2][kingsq])
+                                                        : (Magics::rays[0][kingsq] | Magics::rays[3][kingsq]);
+      const uint64_t rightPinned = (us == Color::WHITE) ? (Magics::rays[0][kingsq] | Magics::rays[3][kingsq])
+                                                        : (Magics::rays[1][kingsq] | Magics::rays[2][kingsq]);
+
+      const uint64_t diagleft = pawns & ~pinsHV & ~(pinsD12 & leftPinned);
+      const uint64_t diagright = pawns & ~pinsHV & ~(pinsD12 & rightPinned);
+
+      if constexpr (type != GenType::CAPTURE){
+         uint64_t single = shiftBy<forward>(pushable & ~lastRank) & ~fullboard;
+         visitPawnTargets<forward>(visit, single & checkmask, 0);
+
+         uint64_t push = shiftBy<forward>(single) & ~fullboard & pushRank;
+         visitPawnTargets<2 * forward>(visit, push & checkmask, Move::DOUBLEPUSH);
+      }
+
+      if constexpr (type == GenType::QUIET) return;
+
+      const uint64_t enemies = occupancy[them] & checkmask;
+
+      visitPawnTargets<left>(visit, shiftBy<left>(skipAfile & diagleft & ~lastRank) & enemies, 0);
+      visitPawnTargets<right>(visit, shiftBy<right>(skipHfile & diagright & ~lastRank) & enemies, 0);
+
+      // en passant
+      int epTargetSq = history[gamePly].epTargetSq;
+      int targetPawn = (epTargetSq - forward);
+
+      if(epTargetSq != -1 && !(pinsD12 & (1ULL << targetPawn))){
+         // check if en passant is a valid response to the check
+         uint64_t checkmaskEP = shiftBy<forward>(checkmask & (1ULL << targetPawn));
+
+         if((1ULL << epTargetSq) & checkmaskEP){
+            const uint64_t opRQ = (pieces[rook][them] | pieces[queen][them]);
+
+            // check if en passant capture can result in check from enemy rook/queen on the same rank
+            uint64_t minusPawn = fullboard ^ (1ULL << targetPawn);
+            uint64_t pinners = Magics::getXRayRookAttacks(minusPawn, occupancy[us], kingsq) & opRQ;
+
+            uint64_t pinned = 0ULL;
+            while(pinners != 0ULL){
+               int enemy = bitScanPop(pinners);
+               pinned |= Magics::flesh[kingsq][enemy];
+            }
+
+            // pawns that can capture towards the en passant square
+            uint64_t candidates = 0ULL;
+            candidates |= (1ULL << (epTargetSq - right)) & ~(pinsD12 & rightPinned) & skipHfile;
+            candidates |= (1ULL << (epTargetSq - left)) & ~(pinsD12 & leftPinned) & skipAfile;
+            candidates &= ~pinsHV;
+
+            // skip pawn moves that could result in check from enemy rook/queen on the same rank
+            candidates &= ~pinned;
+            candidates &= pawns;
+
+            while(candidates != 0ULL){
+               int from = bitScanPop(candidates);
+               visit(Move(from, epTargetSq, Move::ENPASSANT | Move::CAPTURE));
+            }
+         }
+      }
+
+      // promotions, pushes included
+      uint64_t promotions = shiftBy<forward>(pushable & lastRank) & ~fullboard & checkmask;
+      visitPromotionTargets<forward>(visit, promotions, 0);
+
+      visitPromotionTargets<left>(visit, shiftBy<left>(skipAfile & diagleft & lastRank) & enemies, Move::CAPTURE);
+      visitPromotionTargets<right>(visit, shiftBy<right>(skipHfile & diagright & lastRank) & enemies, Move::CAPTURE);
+   }
+
+   template<Color us, GenType type, typename Visitor>
+   void Bitboard::fillKingMoves(const MoveMasks &masks, Visitor &visit){
+      const int sq = masks.kingSq;
+      const uint64_t king = (1ULL << sq);
+      const uint64_t attacked = masks.attacked;
+
+      uint64_t targets = Magics::kingMoves[sq] & targetSquares<us, type>() & ~attacked;
+      visitTargets(visit, sq, targets);
+
+      if constexpr (type == GenType::CAPTURE) return;
+      if(king & attacked) return;
+
+      // check for castling opportunities
+      uint8_t castling = history[gamePly].castling;
+      if constexpr (us == Color::WHITE) castling >>= 2;
+
+      // check kingside castling
+      if(castling & 0b10){
+         int target = sq + 2;
+         int rookSq = (sq - (sq % 8)) + 7;
+         uint64_t open = Magics::flesh[sq][rookSq] & fullboard;
+         uint64_t safe = Magics::flesh[sq][target + 1] & attacked;
+
+         if(!open && !safe){
+            visit(Move(sq, target, Move::CASTLING | Move::KINGSIDE));
+         }
+      }
+
+      // check queenside castling
+      if(castling & 0b01){
+         int target = sq - 2;
+         int rookSq = (sq - (sq % 8));
+         uint64_t open = Magics::flesh[sq][rookSq] & fullboard;
+         uint64_t safe = Magics::flesh[sq][target - 1] & attacked;
+
+         if(!open && !safe){
+            visit(Move(sq, target, Move::CASTLING | Move::QUEENSIDE));
+         }
+      }
+   }
+}
+
+#endif
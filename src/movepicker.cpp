@@ -0,0 +1,160 @@
+#include "movepicker.hpp"
+#include "search.hpp"
+#include "movegen.hpp"
+
+namespace Mufasa{
+   MovePicker::MovePicker(Bitboard &board, const Searcher &searcher, const Move ttmove, const Move killers[2], const Move counter) : board(board), searcher(searcher){
+      this->ttmove = ttmove;
+      this->killers[0] = killers[0];
+      this->killers[1] = killers[1];
+      this->counter = counter;
+   }
+
+   MovePicker::MovePicker(Bitboard &board, const Searcher &searcher) : board(board), searcher(searcher){
+      ttmove = nullmove;
+      killers[0] = nullmove;
+      killers[1] = nullmove;
+      counter = nullmove;
+      stage = PickStage::QS_GENERATE;
+   }
+
+   Move MovePicker::pickBest(size_t end){
+      size_t best = maxIndex(scores, current, end);
+      std::swap(moves[best], moves[current]);
+      std::swap(scores[best], scores[current]);
+      return moves[current++];
+   }
+
+   Move MovePicker::next(){
+      switch(stage){
+         case PickStage::TTMOVE:
+            stage = PickStage::GENERATE;
+            
+            if(!(ttmove == nullmove) && board.isLegal(ttmove)){
+               return ttmove;
+            }
+            
+            ttmove = nullmove;
+            [[fallthrough]];
+
+         case PickStage::GENERATE:{
+            board.fillMoves(moves, GenType::CAPTURE);
+
+            // captures that lose material in the exchange wait until the quiet moves are tried
+            auto winning = [this](const Move move){
+               return (move.getFlags() & Move::PROMOTION) || board.see(move) >= 0;
+            };
+
+            bad = std::partition(moves.begin(), moves.end(), winning) - moves.begin();
+            quiets = moves.size();
+
+            for(size_t i = 0; i < quiets; i++){
+               scores[i] = board.scoreMove(moves[i]) + searcher.captureScore(moves[i]) / 16;
+            }
+
+            stage = PickStage::CAPTURES;
+            [[fallthrough]];
+         }
+
+         case PickStage::CAPTURES:
+            while(current < bad){
+               Move move = pickBest(bad);
+               if(move == ttmove) continue;
+               return move;
+            }
+
+            stage = PickStage::KILLERS;
+            [[fallthrough]];
+
+         case PickStage::KILLERS:
+            while(killer < 2){
+               Move move = killers[killer++];
+               if(move == nullmove || move == ttmove) continue;
+               
+               // killers come from sibling nodes, a capture here was already handed out with the captures
+               if(!board.isCapture(move) && board.isLegal(move)){
+                  return move;
+               }
+            }
+
+            stage = PickStage::COUNTERMOVE;
+            [[fallthrough]];
+
+         case PickStage::COUNTERMOVE:{
+            stage = PickStage::GENERATE_QUIETS;
+
+            if(!(counter == nullmove) && !(counter == ttmove) && !(counter == killers[0]) && !(counter == killers[1])){
+               if(!board.isCapture(counter) && board.isLegal(counter)){
+                  return counter;
+               }
+            }
+
+            counter = nullmove;
+            [[fallthrough]];
+         }
+
+         case PickStage::GENERATE_QUIETS:{
+            auto push = [this](const Move move){
+               scores[moves.size()] = searcher.historyScore(move);
+               moves.push_back(move);
+            };
+
+            board.generateMoves<GenType::QUIET>(push);
+
+            current = quiets;
+            stage = PickStage::QUIETS;
+            [[fallthrough]];
+         }
+
+         case PickStage::QUIETS:
+            while(current < moves.size()){
+               Move move = pickBest(moves.size());
+               if(move == ttmove || move == killers[0] || move == killers[1] || move == counter) continue;
+               return move;
+            }
+
+            current = bad;
+            stage = PickStage::BAD_CAPTURES;
+            [[fallthrough]];
+
+         case PickStage::BAD_CAPTURES:
+            while(current < quiets){
+               Move move = pickBest(quiets);
+               if(move == ttmove) continue;
+               return move;
+            }
+
+            stage = PickStage::FINISHED;
+            [[fallthrough]];
+
+         case PickStage::FINISHED:
+            break;
+
+         case PickStage::QS_GENERATE:{
+            board.fillMoves(moves, GenType::CAPTURE);
+
+            // captures losing material are not worth searching
+            auto winning = [this](const Move move){
+               return (move.getFlags() & Move::PROMOTION) || board.see(move) >= 0;
+            };
+
+            bad = std::partition(moves.begin(), moves.end(), winning) - moves.begin();
+
+            for(size_t i = 0; i < bad; i++){
+               scores[i] = board.scoreMove(moves[i]) + searcher.captureScore(moves[i]) / 16;
+            }
+
+            stage = PickStage::QS_CAPTURES;
+            [[fallthrough]];
+         }
+
+         case PickStage::QS_CAPTURES:
+            if(current < bad) return pickBest(bad);
+
+            stage = PickStage::FINISHED;
+            break;
+      }
+
+      return nullmove;
+   }
+}
@@ -0,0 +1,63 @@
+#ifndef MOVEPICKER_HPP_INCLUDED
+#define MOVEPICKER_HPP_INCLUDED
+
+#include "bitboard.hpp"
+
+namespace Mufasa{
+   class Searcher;
+
+   
+   // Every stage is entered only once the previous one is exhausted
+   enum PickStage{
+      TTMOVE,
+      GENERATE,
+      CAPTURES,
+      KILLERS,
+      COUNTERMOVE,
+      GENERATE_QUIETS,
+      QUIETS,
+      BAD_CAPTURES,
+      FINISHED,
+
+      // quiescence search only tries captures and promotions that do not lose material
+      QS_GENERATE,
+      QS_CAPTURES
+   };
+   
+   // Hands out moves one at a time, most promising first
+   // Nothing is generated as long as the TT move produces a cutoff,
+   // quiet moves only once the captures, killers and the countermove did not
+   // Quiet moves other than the killers and the countermove are tried by their history score
+   // Moves are selected one by one from the scores, most nodes cut off before a full sort would pay off
+   class MovePicker{
+      public:
+      MovePicker(Bitboard &board, const Searcher &searcher, const Move ttmove, const Move killers[2], const Move counter);
+      MovePicker(Bitboard &board, const Searcher &searcher);
+      
+      // returns nullmove once there are no moves left
+      Move next();
+
+      private:
+      Bitboard &board;
+      const Searcher &searcher; // source of the history scores
+      
+      Move ttmove;
+      Move killers[2];
+      Move counter;
+      
+      PickStage stage = PickStage::TTMOVE;
+      
+      MoveList moves;
+      int scores[MoveList::capacity]; // kept apart from the moves so that they can be scanned quickly
+
+      size_t current  = 0;
+      size_t bad      = 0; // captures losing material are stored from this index
+      size_t quiets   = 0; // captures and promotions are stored before this index, quiet moves are appended
+      size_t killer   = 0;
+
+      // moves the best scored move in [current, end) to current and hands it out
+      Move pickBest(size_t end);
+   };
+}
+
+#endif
@@ -0,0 +1,127 @@
+#include "numa.hpp"
+
+#include<new>
+#include<string>
+#include<fstream>
+#include<algorithm>
+
+#ifdef __linux__
+#include<sched.h>
+#include<unistd.h>
+#include<sys/mman.h>
+#include<sys/syscall.h>
+#include<linux/mempolicy.h>
+#endif
+
+namespace Mufasa{
+
+   // reads sysfs lists like "0-15,32-47", empty if the file does not exist
+   static std::vector<int> readList(const std::string &path){
+      std::vector<int> values;
+      std::ifstream file(path);
+      std::string range;
+
+      while(std::getline(file, range, ',')){
+         size_t dash = range.find('-');
+         int first = std::stoi(range);
+         int last = (dash == std::string::npos) ? first : std::stoi(range.substr(dash + 1));
+
+         for(int value = first; value <= last; value++) values.push_back(value);
+      }
+
+      return values;
+   }
+
+   const std::vector<std::vector<int>>& Numa::topology(){
+      static const std::vector<std::vector<int>> cpus = []{
+         std::vector<std::vector<int>> nodes;
+#ifdef __linux__
+         // nodes with memory only have no cpus to bind to
+         for(int node : readList("/sys/devices/system/node/online")){
+            std::vector<int> list = readList("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+            if(!list.empty()) nodes.push_back(list);
+         }
+#endif
+         return nodes;
+      }();
+
+      return cpus;
+   }
+
+   int Numa::nodes(){
+      return std::max<int>(1, topology().size());
+   }
+
+   int Numa::nodeOf(int thread){
+      return thread % nodes();
+   }
+
+   // on a single node there is nothing to gain and the user might have pinned the process on purpose
+   void Numa::bindThread(int thread){
+#ifdef __linux__
+      if(nodes() < 2) return;
+
+      cpu_set_t set;
+      CPU_ZERO(&set);
+
+      for(int cpu : topology()[nodeOf(thread)]){
+         if(cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+      }
+
+      sched_setaffinity(0, sizeof(set), &set);
+#else
+      (void)thread;
+#endif
+   }
+
+   void Numa::unbindThread(){
+#ifdef __linux__
+      if(nodes() < 2) return;
+
+      cpu_set_t set;
+      CPU_ZERO(&set);
+
+      for(const auto &node : topology()){
+         for(int cpu : node){
+            if(cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+         }
+      }
+
+      sched_setaffinity(0, sizeof(set), &set);
+#endif
+   }
+
+   void* Numa::allocateInterleaved(size_t bytes){
+#ifdef __linux__
+      // fresh pages from mmap are not touched yet, so the policy decides where every one of them goes
+      void* memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if(memory == MAP_FAILED) throw std::bad_alloc();
+
+      std::vector<int> memoryNodes = readList("/sys/devices/system/node/has_memory");
+
+      if(memoryNodes.size() > 1){
+         const size_t bits = 8 * sizeof(unsigned long);
+         std::vector<unsigned long> mask(*std::max_element(memoryNodes.begin(), memoryNodes.end()) / bits + 1, 0);
+
+         for(int node : memoryNodes) mask[node / bits] |= (1UL << (node % bits));
+
+         // on failure the pages just stay local to whoever touches them first
+         syscall(SYS_mbind, memory, bytes, MPOL_INTERLEAVE, mask.data(), mask.size() * bits + 1, 0);
+      }
+
+      return memory;
+#else
+      return ::operator new(bytes, std::align_val_t(64));
+#endif
+   }
+
+   void Numa::release(void* memory, size_t bytes){
+      if(!memory) return;
+#ifdef __linux__
+      munmap(memory, bytes);
+#else
+      (void)bytes;
+      ::operator delete(memory, std::align_val_t(64));
+#endif
+   }
+}
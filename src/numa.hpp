@@ -0,0 +1,34 @@
+#ifndef NUMA_HPP_INCLUDED
+#define NUMA_HPP_INCLUDED
+
+#include<vector>
+#include<cstddef>
+
+namespace Mufasa{
+
+   // Placement of search threads and memory on machines with several NUMA nodes
+   // Only Linux is supported, elsewhere the machine is treated as a single node
+   // and the operating system decides where threads run and memory lives
+   class Numa{
+      public:
+      static int nodes();
+
+      // node the given search thread belongs to, threads are dealt out round robin
+      static int nodeOf(int thread);
+
+      // restricts the calling thread to the cpus of the node of the given search thread,
+      // memory it touches first is then allocated on that node
+      static void bindThread(int thread);
+      static void unbindThread();
+
+      // pages are spread over all nodes, so that no single memory controller serves every probe
+      static void* allocateInterleaved(size_t bytes);
+      static void release(void* memory, size_t bytes);
+
+      private:
+      // cpus of every node, read once from sysfs
+      static const std::vector<std::vector<int>>& topology();
+   };
+}
+
+#endif
@@ -2,12 +2,13 @@
 #define PIECE_HPP_INCLUDED
 
 #include<map>
+#include<cstdint>
 #include<vector>
 #include<cassert>
 #include<iostream>
       
 namespace Mufasa{
-   enum Figure{
+   enum Figure : uint8_t{
       NONE = 0,
       PAWN = 1,
       KNIGHT = 2,
@@ -17,7 +18,7 @@ namespace Mufasa{
       KING = 6
    };
 
-   enum Color{
+   enum Color : uint8_t{
       WHITE = 0,
       BLACK = 1,
       COUNT = 2,
@@ -49,6 +50,11 @@ namespace Mufasa{
       }
       friend std::ostream& operator<<(std::ostream &os, const Piece &piece);
    };
+
+   // white pieces first, from pawn to king, then black ones
+   inline int pieceIndex(const Piece piece){
+      return piece.getColor() * 6 + piece.getFigure() - 1;
+   }
 }
 
 #endif
@@ -3,8 +3,10 @@
 
 #include "misc.hpp"
 
+#include<array>
+
 namespace Mufasa{
-    inline const int pawnsMG[64] = {
+    inline constexpr int pawnsMG[64] = {
           0,   0,   0,   0,   0,   0,   0,   0,
 			50,  50,  50,  50,  50,  50,  50,  50,
 			10,  10,  20,  30,  30,  20,  10,  10,
@@ -15,7 +17,7 @@ namespace Mufasa{
 			 0,   0,   0,   0,   0,   0,   0,   0
    };
 
-    inline const int pawnsEG[64] = {
+    inline constexpr int pawnsEG[64] = {
    	    0,   0,   0,   0,   0,   0,   0,   0,
 			80,  80,  80,  80,  80,  80,  80,  80,
 			50,  50,  50,  50,  50,  50,  50,  50,
@@ -26,7 +28,7 @@ namespace Mufasa{
 			 0,   0,   0,   0,   0,   0,   0,   0		 
    };
 
-    inline const int knightsMG[64] = {
+    inline constexpr int knightsMG[64] = {
    	 -167, -89, -34, -49,  61, -97, -15, -107,
         -73, -41,  72,  36,  23,  62,   7,  -17,
         -47,  60,  37,  65,  84, 129,  73,   44,
@@ -37,7 +39,7 @@ namespace Mufasa{
        -105, -21, -58, -33, -17, -28, -19,  -23, 
    };
 
-    inline const int knightsEG[64] = {
+    inline constexpr int knightsEG[64] = {
        -58, -38, -13, -28, -31, -27, -63, -99,
        -25,  -8, -25,  -2,  -9, -25, -24, -52,
        -24, -20,  10,   9,  -1,  -9, -19, -41,
@@ -48,7 +50,7 @@ namespace Mufasa{
        -29, -51, -23, -15, -22, -18, -50, -64,
    };
 
-    inline const int bishopsMG[64] = {
+    inline constexpr int bishopsMG[64] = {
        -29,   4, -82, -37, -25, -42,   7,  -8,
        -26,  16, -18, -13,  30,  59,  18, -47,
        -16,  37,  43,  40,  35,  50,  37,  -2,
@@ -59,7 +61,7 @@ namespace Mufasa{
        -33,  -3, -14, -21, -13, -12, -39, -21,
    };
 
-    inline const int bishopsEG[64] = {
+    inline constexpr int bishopsEG[64] = {
        -14, -21, -11,  -8, -7,  -9, -17, -24,
         -8,  -4,   7, -12, -3, -13,  -4, -14,
          2,  -8,   0,  -1, -2,   6,   0,   4,
@@ -70,7 +72,7 @@ namespace Mufasa{
        -23,  -9, -23,  -5, -9, -16,  -5, -17,
    };
 
-    inline const int rooksMG[64] = {
+    inline constexpr int rooksMG[64] = {
         32,  42,  32,  51, 63,  9,  31,  43,
         27,  32,  58,  62, 80, 67,  26,  44,
         -5,  19,  26,  36, 17, 45,  61,  16,
@@ -81,7 +83,7 @@ namespace Mufasa{
        -19, -13,   1,  17, 16,  7, -37, -26,
    };
 
-    inline const int rooksEG[64] = {
+    inline constexpr int rooksEG[64] = {
        13, 10, 18, 15, 12,  12,   8,   5,
        11, 13, 13, 11, -3,   3,   8,   3,
         7,  7,  7,  5,  4,  -3,  -5,  -3,
@@ -92,7 +94,7 @@ namespace Mufasa{
        -9,  2,  3, -1, -5, -13,   4, -20,
    };
 
-   inline const int queensMG[64] = {
+   inline constexpr int queensMG[64] = {
        -28,   0,  29,  12,  59,  44,  43,  45,
        -24, -39,  -5,   1, -16,  57,  28,  54,
        -13, -17,   7,   8,  29,  56,  47,  57,
@@ -103,7 +105,7 @@ namespace Mufasa{
         -1, -18,  -9,  10, -15, -25, -31, -50,
    };
 
-   inline const int queensEG[64] = {
+   inline constexpr int queensEG[64] = {
         -9,  22,  22,  27,  27,  19,  10,  20,
        -17,  20,  32,  41,  58,  25,  30,   0,
        -20,   6,   9,  49,  47,  35,  19,   9,
@@ -114,7 +116,7 @@ namespace Mufasa{
        -33, -28, -22, -43,  -5, -32, -20, -41,
    };
 
-   inline const int kingsMG[64] = {
+   inline constexpr int kingsMG[64] = {
        -65,  23,  16, -15, -56, -34,   2,  13,
         29,  -1, -20,  -7,  -8,  -4, -38, -29,
         -9,  24,   2, -16, -20,   6,  22, -22,
@@ -125,7 +127,7 @@ namespace Mufasa{
        -15,  36,  12, -54,   8, -28,  24,  14,
    };
 
-   inline const int kingsEG[64] = {
+   inline constexpr int kingsEG[64] = {
        -74, -35, -18, -18, -11,  15,   4, -17,
        -12,  17,  14,  17,  17,  38,  23,  11,
         10,  17,  23,  15,  20,  45,  44,  13,
@@ -136,7 +138,7 @@ namespace Mufasa{
        -53, -34, -21, -11, -28, -14, -24, -43
    };
 
-   inline const int* pestoMG[6] = {
+   inline constexpr const int* pestoMG[6] = {
       pawnsMG,
       knightsMG,
       bishopsMG,
@@ -145,7 +147,7 @@ namespace Mufasa{
       kingsMG
    };
 
-   inline const int* pestoEG[6] = {
+   inline constexpr const int* pestoEG[6] = {
       pawnsEG,
       knightsEG,
       bishopsEG,
@@ -154,13 +156,26 @@ namespace Mufasa{
       kingsEG
    };
    
-   inline const int pieceValue[6] = {100, 300, 300, 500, 900, 0};
+   inline constexpr int pieceValue[6] = {100, 300, 300, 500, 900, 0};
    
-   extern const int gamephaseInc[6];
-   extern int tablesMG[2][6][64];
-   extern int tablesEG[2][6][64];
-
-   void initPSQT();
+   inline constexpr int gamephaseInc[6] = {0, 1, 1, 2, 4, 0};
+
+   using PieceSquareTable = std::array<std::array<std::array<int, 64>, 6>, 2>;
+
+   // material is folded into the tables, black reads them flipped vertically
+   constexpr PieceSquareTable buildPSQT(const int* const (&pesto)[6]){
+      PieceSquareTable table{};
+      for(int piece = 0; piece < 6; piece++){
+         for(int sq = 0; sq < 64; sq++){
+            table[0][piece][sq] = pesto[piece][sq] + pieceValue[piece];
+            table[1][piece][sq] = pesto[piece][sq ^ 56] + pieceValue[piece];
+         }
+      }
+      return table;
+   }
+
+   inline constexpr PieceSquareTable tablesMG = buildPSQT(pestoMG);
+   inline constexpr PieceSquareTable tablesEG = buildPSQT(pestoEG);
 }
 
 #endif
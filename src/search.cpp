@@ -0,0 +1,371 @@
+#include "search.hpp"
+#include "movepicker.hpp"
+
+namespace Mufasa{
+   Searcher::Searcher(int id, const std::atomic<bool> &stop, const Pool &pool) : id(id), stop(stop), pool(pool){
+      continuationHistory.assign(12 * 64 * 12 * 64, 0);
+   }
+
+   void Searcher::setPosition(const Bitboard &position){
+      board = position;
+   }
+
+   void Searcher::setDue(uint64_t due, uint64_t start){
+      duetime = due;
+      initime = start;
+   }
+
+   void Searcher::setDeadline(uint64_t due){
+      duetime.store(due, std::memory_order_relaxed);
+   }
+
+   uint64_t Searcher::getNodes() const{
+      return nodes.load(std::memory_order_relaxed);
+   }
+
+   uint64_t Searcher::getHits() const{
+      return tthits.load(std::memory_order_relaxed);
+   }
+
+   bool Searcher::timeout(){
+      if(stopped) return true;
+
+      // the main thread always finishes the first iteration, so that there is a move to play
+      if(!id && !completedDepth) return false;
+
+      if(stop.load(std::memory_order_relaxed) || (++polls % POLL_INTERVAL == 0 && now() >= duetime.load(std::memory_order_relaxed))){
+         stopped = true;
+      }
+
+      return stopped;
+   }
+
+   int Searcher::historyScore(const Move move) const{
+      int score = quietHistory[board.sideToMove()][move.start()][move.end()];
+
+      for(int back = 0; back < 2 && back <= board.getGamePly(); back++){
+         const BoardState &earlier = board.getState(back);
+         if(earlier.moved < 0) break;
+
+         score += continuationHistory[continuationIndex(earlier, move)];
+      }
+
+      return score;
+   }
+
+   int Searcher::captureScore(const Move move) const{
+      Figure captured = (move.getFlags() & Move::ENPASSANT) ? Figure::PAWN : board.getPiece(move.end()).getFigure();
+      if(captured == Figure::NONE) return 0;
+
+      return captureHistory[pieceIndex(board.getPiece(move.start()))][move.end()][captured - 1];
+   }
+
+   Move Searcher::counterMove() const{
+      const Move previous = board.getState().previous;
+      return counterMoves[previous.start()][previous.end()];
+   }
+
+   int& Searcher::captureEntry(const Move move){
+      Figure captured = (move.getFlags() & Move::ENPASSANT) ? Figure::PAWN : board.getPiece(move.end()).getFigure();
+      return captureHistory[pieceIndex(board.getPiece(move.start()))][move.end()][captured - 1];
+   }
+
+   // entry for the move following the one that led to the earlier state
+   size_t Searcher::continuationIndex(const BoardState &earlier, const Move move) const{
+      size_t index = (size_t(earlier.moved) * 64 + earlier.previous.end()) * 12 * 64;
+      return index + pieceIndex(board.getPiece(move.start())) * 64 + move.end();
+   }
+
+   // scores approach the bound more slowly the closer they are to it
+   template<typename T>
+   static void addBonus(T &entry, int bonus){
+      entry += bonus - entry * std::abs(bonus) / MAX_HISTORY_SCORE;
+   }
+
+   void Searcher::updateQuietHistory(const Move move, int bonus){
+      addBonus(quietHistory[board.sideToMove()][move.start()][move.end()], bonus);
+
+      for(int back = 0; back < 2 && back <= board.getGamePly(); back++){
+         const BoardState &earlier = board.getState(back);
+         if(earlier.moved < 0) break;
+
+         addBonus(continuationHistory[continuationIndex(earlier, move)], bonus);
+      }
+   }
+
+   // scores from earlier searches are still useful, but should not outweigh new ones
+   void Searcher::ageHistory(){
+      for(auto &entry : continuationHistory) entry /= 2;
+
+      for(int from = 0; from < 64; from++){
+         for(int to = 0; to < 64; to++){
+            quietHistory[0][from][to] /= 2;
+            quietHistory[1][from][to] /= 2;
+            counterMoves[from][to] = nullmove;
+         }
+      }
+
+      for(auto &piece : captureHistory){
+         for(auto &square : piece){
+            for(auto &entry : square) entry /= 2;
+         }
+      }
+   }
+
+   std::pair<int, Move> Searcher::bestMove(int depth, TimeManager *manager){
+      Move bestMove = nullmove;
+      int lastScore = 0;
+
+      ply = 0;
+      polls = 0;
+      stopped = false;
+      nodes = 0;
+      tthits = 0;
+      completedDepth = 0;
+      completedMove = nullmove;
+      completedPonder = nullmove;
+
+      for(int i = 0; i < MAX_PLY; i++){
+         killers[i][0] = nullmove;
+         killers[i][1] = nullmove;
+      }
+
+      ageHistory();
+
+      // every other helper skips the first iteration, so that the threads do not search in lockstep
+      for(int d = 1 + (id & 1); d <= depth && !timeout(); d++){
+         int score;
+         Move move;
+         MoveList principle;
+
+         if(d <= 4){
+            std::tie(score, move) = negaMax(d, -oo, oo, principle);
+         }
+         else{
+            int window = 20;
+            int alpha = lastScore - window;
+            int beta = lastScore + window;
+
+            std::tie(score, move) = negaMax(d, alpha, beta, principle);
+
+            while((score <= alpha || score >= beta) && !timeout()){
+               if(score <= alpha){
+                  alpha -= window;
+               }
+               else if(score >= beta){
+                  beta += window;
+               }
+
+               std::tie(score, move) = negaMax(d, alpha, beta, principle);
+               window *= 2;
+            }
+         }
+
+         // an unfinished iteration has neither a score nor a move worth reporting
+         if(!timeout()){
+            if(!id){
+               uint64_t total = 0, hits = 0;
+               for(const auto &thread : pool){
+                  total += thread->getNodes();
+                  hits += thread->getHits();
+               }
+
+               // written at once, so that it does not interleave with replies of the UCI thread
+               std::ostringstream info;
+               info << "info depth " << d << " hits " << hits << " nodes " << total << " time " << (now() - initime);
+               info << " score cp " << score << " pv " << move << "\n";
+               std::cout << info.str() << std::flush;
+            }
+
+            lastScore = score;
+            bestMove = move;
+
+            completedDepth = d;
+            completedScore = score;
+            completedMove = move;
+
+            // the variation is stored leaf first
+            completedPonder = (principle.size() >= 2) ? principle[principle.size() - 2] : nullmove;
+
+            if(manager && manager->enough(move, score)) break;
+         }
+
+         if(score == oo) break;
+      }
+
+      return {lastScore, bestMove};
+   }
+
+   // Quiescence Search
+   // https://www.chessprogramming.org/Quiescence_Search
+   // Searches for positions where there are no captures
+   // to avoid horizon effect in leaves
+
+   int Searcher::quietSearch(int alpha, int beta){
+      int standPat = board.evaluate();
+
+      if(standPat >= beta) return beta;
+
+      if(alpha < standPat) alpha = standPat;
+
+      if(timeout()) return alpha;
+
+      MovePicker picker(board, *this);
+      Move move;
+
+      while(!((move = picker.next()) == nullmove)){
+         board.makeMove(move);
+         int score = -quietSearch(-beta, -alpha);
+         board.unmakeMove(move);
+
+         if(score >= beta) return beta;
+         if(score > alpha) alpha = score;
+      }
+
+      return alpha;
+   }
+
+   std::pair<int, Move> Searcher::negaMax(int depth, int alpha, int beta, MoveList &principle){
+      int max = -oo;
+      Move best = nullmove;
+
+      nodes.store(nodes.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+      if(timeout()){
+         return {beta, best};
+      }
+
+      if(depth <= 0){
+         max = quietSearch(alpha, beta);
+         return {max, best};
+      }
+
+      const uint64_t zobrist = board.zobristHash();
+
+      TTData tthit;
+      Move ttmove = nullmove;
+
+      if(TT.probe(zobrist, tthit)){
+         ttmove = tthit.move;
+
+         // the root move is played, so it always comes from a search and never from an entry
+         // that might belong to another position or be torn
+         if(ply && tthit.depth >= depth){
+            tthits.store(tthits.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+            switch(tthit.type){
+               case EXACT:
+                  return {tthit.score, tthit.move};
+               case LOWER:
+                  if(tthit.score <= alpha)
+                     return {alpha, tthit.move};
+                  break;
+               case UPPER:
+                  if(tthit.score >= beta)
+                     return {beta, tthit.move};
+                  break;
+            }
+         }
+      }
+
+      MovePicker picker(board, *this, ttmove, killers[ply], counterMove());
+
+      MoveList next;
+      MoveList quiets;   // quiet moves searched before the current one
+      MoveList captures; // same for captures
+
+      EntryType nodeType = LOWER;
+      int legalMoves = 0;
+      Move move;
+
+      while(!((move = picker.next()) == nullmove)){
+         const bool capture = board.isCapture(move);
+         const bool quiet = !capture && !(move.getFlags() & Move::PROMOTION);
+
+         board.makeMove(move);
+         ply++;
+
+         // the child probes the table unless it drops into quiescence
+         if(depth > 1) TT.prefetch(board.zobristHash());
+
+         MoveList continuation;
+         auto [score, pv] = negaMax(depth - 1, -beta, -alpha, continuation);
+
+         if(board.countRepetitions() >= 3) score = 0;
+
+         ply--;
+         board.unmakeMove(move);
+
+         // the child was cut short, neither its score nor the rest of the moves can be trusted
+         if(stopped) break;
+
+         score = -score;
+
+         // make sure we always have a move to play even if all of them are losing
+         if(!legalMoves++) best = move;
+
+         if(score > max){
+            next = continuation;
+            max = score;
+            if(alpha < max){
+               alpha = max;
+               nodeType = EXACT;
+            }
+
+            best = move;
+         }
+
+         if(alpha >= beta){
+            nodeType = UPPER;
+
+            // moves that cause a cutoff are likely to do so in sibling nodes
+            // and the moves tried before it are likely to fail again
+            const int bonus = std::min(depth * depth, MAX_HISTORY_SCORE / 16);
+            if(quiet){
+               if(!(killers[ply][0] == move)){
+                  killers[ply][1] = killers[ply][0];
+                  killers[ply][0] = move;
+               }
+
+               const Move previous = board.getState().previous;
+               counterMoves[previous.start()][previous.end()] = move;
+
+               updateQuietHistory(move, bonus);
+               for(const auto &tried : quiets){
+                  updateQuietHistory(tried, -bonus);
+               }
+            }
+            else if(capture){
+               addBonus(captureEntry(move), bonus);
+            }
+
+            for(const auto &tried : captures){
+               addBonus(captureEntry(tried), -bonus);
+            }
+            break;
+         }
+
+         if(quiet) quiets.push_back(move);
+         else if(capture) captures.push_back(move);
+      }
+
+      // an unfinished search must not leave its result in the table for later ones
+      if(stopped) return {max, best};
+
+      if(!legalMoves){
+         if(!board.inCheck()){
+            max = 0;
+         }
+         else{
+            max = -oo;
+         }
+      }
+
+      principle = next;
+      principle.push_back(best);
+
+      TT.store(zobrist, depth, max, board.evaluate(), best, nodeType);
+
+      return {max, best};
+   }
+}
@@ -0,0 +1,94 @@
+#ifndef SEARCH_HPP_INCLUDED
+#define SEARCH_HPP_INCLUDED
+
+#include "bitboard.hpp"
+#include "tt.hpp"
+#include "timeman.hpp"
+
+#include<atomic>
+#include<memory>
+#include<vector>
+#include<sstream>
+
+namespace Mufasa{
+
+   // Everything one search thread owns: its copy of the position, move ordering tables and counters
+   // Threads of a Lazy SMP search share nothing mutable but the transposition table
+   class Searcher{
+      public:
+      using Pool = std::vector<std::unique_ptr<Searcher>>;
+
+      // the pool is only read by the main thread to report totals of the whole search
+      Searcher(int id, const std::atomic<bool> &stop, const Pool &pool);
+
+      void setPosition(const Bitboard &position);
+      void setDue(uint64_t due, uint64_t start);
+
+      // moves the due time of a running search, e.g. on ponderhit
+      void setDeadline(uint64_t due);
+
+      // iterative deepening, only the main thread reports progress and asks the time manager
+      // whether another iteration is worth starting
+      std::pair<int, Move> bestMove(int depth, TimeManager *manager = nullptr);
+
+      int historyScore(const Move move) const;
+      int captureScore(const Move move) const;
+      Move counterMove() const;
+
+      uint64_t getNodes() const;
+      uint64_t getHits() const;
+
+      // last fully searched iteration, read once the search is over
+      int completedDepth = 0;
+      int completedScore = 0;
+      Move completedMove = nullmove;
+      Move completedPonder = nullmove; // expected reply, second move of the principal variation
+
+      private:
+      const int id;
+      const std::atomic<bool> &stop;
+      const Pool &pool;
+
+      Bitboard board;
+
+      // written by the owning thread only, atomic so that the main thread can add them up
+      std::atomic<uint64_t> nodes{0};
+      std::atomic<uint64_t> tthits{0};
+
+      std::atomic<uint64_t> duetime{0}; // due time we finish the search, moved by ponderhit
+      uint64_t initime = 0;
+
+      // the clock is only read every few polls, once stopped the search stays stopped
+      static const int POLL_INTERVAL = 1024;
+      int polls = 0;
+      bool stopped = false;
+
+      int ply = 0; // distance from the root of the search
+      Move killers[MAX_PLY][2];
+
+      // how often a quiet move caused a cutoff, by side to move, from and to squares
+      int quietHistory[2][64][64] = {};
+
+      // how often a capture caused a cutoff, by moving piece, target square and captured figure
+      int captureHistory[12][64][6] = {};
+
+      // how often a quiet move caused a cutoff after the moves one and two plies earlier,
+      // by piece and target square of the earlier move and then of the quiet move
+      std::vector<int16_t> continuationHistory;
+
+      // quiet move that refuted the previous move, by its from and to squares
+      Move counterMoves[64][64] = {};
+
+      bool timeout();
+
+      int& captureEntry(const Move move);
+      size_t continuationIndex(const BoardState &earlier, const Move move) const;
+      void updateQuietHistory(const Move move, int bonus);
+      void ageHistory();
+
+      int quietSearch(int alpha, int beta);
+      std::pair<int, Move> negaMax(int depth, int alpha, int beta, MoveList &principle);
+   };
+}
+
+#endif
@@ -0,0 +1,247 @@
+#ifndef TABLES_HPP_INCLUDED
+#define TABLES_HPP_INCLUDED
+
+#include<array>
+#include<cstdint>
+
+// Everything here is evaluated by the compiler, so the
+// engine starts without computing any lookup tables
+
+namespace Mufasa{
+   using SquareTable = std::array<uint64_t, 64>;
+   using RayTable    = std::array<SquareTable, 8>;
+   using PairTable   = std::array<SquareTable, 64>;
+   using ZobristPieceTable = std::array<std::array<SquareTable, 2>, 6>;
+
+   // offset is where the square's attacks start in the shared slider table
+   struct MagicEntry{
+      uint64_t mask;
+      uint64_t magic;
+      uint32_t offset;
+      int shift; 
+   };
+
+   using MagicTable = std::array<MagicEntry, 64>;
+
+   // NW NE SW SE N E S W
+   // First four rays are diagonal attacks, next four are rook attacks
+   // In each set of four the first half are positive rays, the next half negative
+   constexpr int rayDirs[8][2] = {{-1, 1}, {1, 1}, {-1, -1}, {1, -1}, 
+                                  {0, 1}, {1, 0}, {0, -1}, {-1, 0}};
+
+   // returns -1 if the step leaves the board
+   constexpr int step(int sq, int dx, int dy){
+      if(sq < 0) return -1;
+      int file = sq % 8 + dx;
+      int rank = sq / 8 + dy;
+      if(file < 0 || file > 7 || rank < 0 || rank > 7) return -1;
+      return rank * 8 + file;
+   }
+
+   template<size_t N>
+   constexpr SquareTable stepTable(const int (&steps)[N][2]){
+      SquareTable table{};
+      for(int sq = 0; sq < 64; sq++){
+         for(size_t i = 0; i < N; i++){
+            int target = step(sq, steps[i][0], steps[i][1]);
+            if(target >= 0) table[sq] |= (1ULL << target);
+         }
+      }
+      return table;
+   }
+
+   constexpr int wpawnPushSteps[1][2]   = {{0, 1}};
+   constexpr int bpawnPushSteps[1][2]   = {{0, -1}};
+   constexpr int wpawnAttackSteps[2][2] = {{-1, 1}, {1, 1}};
+   constexpr int bpawnAttackSteps[2][2] = {{-1, -1}, {1, -1}};
+   constexpr int knightSteps[8][2] = {{1, 2}, {-1, 2}, {1, -2}, {-1, -2}, {2, 1}, {2, -1}, {-2, 1}, {-2, -1}};
+   constexpr int kingSteps[8][2]   = {{1, 1}, {-1, 1}, {1, -1}, {-1, -1}, {0, 1}, {1, 0}, {0, -1}, {-1, 0}};
+
+   constexpr RayTable rayTable(){
+      RayTable table{};
+      for(int dir = 0; dir < 8; dir++){
+         for(int sq = 0; sq < 64; sq++){
+            int target = step(sq, rayDirs[dir][0], rayDirs[dir][1]);
+            while(target != -1){
+               table[dir][sq] |= (1ULL << target);
+               target = step(target, rayDirs[dir][0], rayDirs[dir][1]);
+            }
+         }
+      }
+      return table;
+   }
+
+   // union of four rays starting at firstDir, slider attacks on an empty board
+   constexpr SquareTable raysUnionTable(const RayTable& rays, int firstDir){
+      SquareTable table{};
+      for(int sq = 0; sq < 64; sq++){
+         for(int dir = firstDir; dir < firstDir + 4; dir++){
+            table[sq] |= rays[dir][sq];
+         }
+      }
+      return table;
+   }
+
+   constexpr SquareTable leftHalfTable(){
+      SquareTable table{};
+      for(int sq = 0; sq < 64; sq++){
+         for(int filler = 0; filler < 64; filler++){
+            if(filler % 8 < sq % 8) table[sq] |= (1ULL << filler);
+         }
+      }
+      return table;
+   }
+
+   constexpr SquareTable rightHalfTable(){
+      SquareTable table{};
+      for(int sq = 0; sq < 64; sq++){
+         for(int filler = 0; filler < 64; filler++){
+            if(filler % 8 > sq % 8) table[sq] |= (1ULL << filler);
+         }
+      }
+      return table;
+   }
+
+   constexpr PairTable connectTable(const RayTable& rays){
+      PairTable table{};
+      for(int from = 0; from < 64; from++){
+         for(int to = 0; to < 64; to++){
+            if(from == to) continue;
+
+            for(int dir = 0; dir < 8; dir++){
+               if(rays[dir][from] & (1ULL << to)) table[from][to] |= rays[dir][from];
+               if(rays[dir][to] & (1ULL << from)) table[from][to] |= rays[dir][to];
+            }
+         }
+      }
+      return table;
+   }
+
+   constexpr PairTable fleshTable(const RayTable& rays){
+      PairTable table{};
+      for(int from = 0; from < 64; from++){
+         for(int to = 0; to < 64; to++){
+            if(from == to) continue;
+
+            for(int dir = 0; dir < 8; dir++){
+               uint64_t line = rays[dir][from];
+               if(line & (1ULL << to)){
+                  line ^= rays[dir][to];
+                  line &= ~(1ULL << to);
+                  table[from][to] |= line;
+               }
+            }
+         }
+      }
+      return table;
+   }
+
+   // Relevant occupancy for sliders, the last square of every ray
+   // never changes the attack set so it is left out of the mask
+   constexpr uint64_t sliderMask(int sq, int firstDir){
+      uint64_t mask = 0ULL;
+      for(int dir = firstDir; dir < firstDir + 4; dir++){
+         int target = step(sq, rayDirs[dir][0], rayDirs[dir][1]);
+         while(target != -1 && step(target, rayDirs[dir][0], rayDirs[dir][1]) != -1){
+            mask |= (1ULL << target);
+            target = step(target, rayDirs[dir][0], rayDirs[dir][1]);
+         }
+      }
+      return mask;
+   }
+
+   constexpr int bitCount(uint64_t bb){
+      int count = 0;
+      for(; bb; bb &= (bb - 1)) count++;
+      return count;
+   }
+
+   // Found offline with a random sparse search, each magic maps
+   // its mask onto exactly popCount(mask) index bits, so every
+   // square only needs 2^popCount(mask) entries in the table
+   constexpr uint64_t bishopMagicNumbers[64] = {
+      0x8040108402448420ULL, 0x8020010111050020ULL, 0x0018408400941000ULL, 0x8104440085803010ULL,
+      0x4804104542001000ULL, 0x460201442080C820ULL, 0x0410880842104081ULL, 0x0200240108011100ULL,
+      0xA01051C408008400ULL, 0x440820085F004090ULL, 0x14C0902120490200ULL, 0x8200210501008010ULL,
+      0x0038440420010812ULL, 0x0442082410081104ULL, 0x0011C20201600880ULL, 0x00D4A10041046023ULL,
+      0x0010004250020082ULL, 0x020E002004494208ULL, 0x0008040108010011ULL, 0x0024029802102028ULL,
+      0x000A100401040160ULL, 0x0052802808842020ULL, 0x40140108808410A2ULL, 0x0100408088441000ULL,
+      0x0608055008111010ULL, 0x0428024021120210ULL, 0x6008070008840100ULL, 0x88400410A2020008ULL,
+      0x0004082014002000ULL, 0x1180A08088080400ULL, 0x8418007002010C04ULL, 0x0D42042454848800ULL,
+      0x0401A01001200404ULL, 0x1088042200900280ULL, 0x000014040102080AULL, 0x0011200900080050ULL,
+      0x8551100400008020ULL, 0x4140810A00010089ULL, 0x2028094048040200ULL, 0x0094840102094900ULL,
+      0x0004020804504000ULL, 0x0000808860008828ULL, 0x0080231048101000ULL, 0x0021102011140800ULL,
+      0x0800080904000111ULL, 0x0020120060402602ULL, 0x80030A1822020104ULL, 0x0011080083001084ULL,
+      0x04508808A8040022ULL, 0x0000406818080820ULL, 0x2104410080D00209ULL, 0x0008220084040020ULL,
+      0x4020001142020041ULL, 0x0040208262020000ULL, 0x1C09020802040284ULL, 0x1030108101002880ULL,
+      0x0101002804020900ULL, 0x0000004048080804ULL, 0x8060014080480840ULL, 0x0105440020208800ULL,
+      0x5200290010202200ULL, 0x0024014861281880ULL, 0x0100450802041403ULL, 0x3D20200220810410ULL
+   };
+
+   constexpr uint64_t rookMagicNumbers[64] = {
+      0x208000801228C000ULL, 0x0240100020004000ULL, 0x0880200208801000ULL, 0x0100082204100100ULL,
+      0x828014008008000AULL, 0x0500040002081300ULL, 0x04004408110A0090ULL, 0x4200002640830412ULL,
+      0x4800800020804000ULL, 0x0210400040201000ULL, 0x0000802000100080ULL, 0x0020801000080081ULL,
+      0x0008800800040080ULL, 0x002200120028510CULL, 0x4203000D00020004ULL, 0x004200004C021085ULL,
+      0x0080014000A00043ULL, 0x2810024020004000ULL, 0x9003410019002000ULL, 0x4000848010020800ULL,
+      0x1004008008000480ULL, 0x0000280110402044ULL, 0x0200808001000200ULL, 0x0240420000408401ULL,
+      0x0480802080004002ULL, 0x0040002020100802ULL, 0x1402410300200032ULL, 0x8000080080100080ULL,
+      0x0001000500080050ULL, 0x0002008080040002ULL, 0x0494018400100208ULL, 0x8508802080005100ULL,
+      0x0041400866800080ULL, 0x0320400080802000ULL, 0x0000A00082801008ULL, 0x0008008008801001ULL,
+      0x1004080011000500ULL, 0x0091C00408011060ULL, 0x0120900104000288ULL, 0x00B8009112001044ULL,
+      0x0080004020004008ULL, 0x7040100800212000ULL, 0x0030002000808010ULL, 0x0041001000210008ULL,
+      0x0000040008008080ULL, 0x6C11000400090002ULL, 0x0580040200010100ULL, 0x4800004885060004ULL,
+      0x0080004000200040ULL, 0x0000804000200080ULL, 0x4020100082200480ULL, 0x0000880080500480ULL,
+      0x2401000800100500ULL, 0x0201000802040100ULL, 0x2100080190420400ULL, 0x4048008041040200ULL,
+      0x0000800100204011ULL, 0x2140400820801103ULL, 0x00280A0010802042ULL, 0x4004201D01300089ULL,
+      0x8216001008200402ULL, 0x180100421824004DULL, 0x0000184C90020104ULL, 0x2500010400508022ULL
+   };
+
+   // squares are laid out back to back starting at offset
+   constexpr MagicTable magicTable(const uint64_t (&numbers)[64], int firstDir, uint32_t offset){
+      MagicTable table{};
+      for(int sq = 0; sq < 64; sq++){
+         uint64_t mask = sliderMask(sq, firstDir);
+         int bits = bitCount(mask);
+         table[sq] = {mask, numbers[sq], offset, 64 - bits};
+         offset += (1U << bits);
+      }
+      return table;
+   }
+
+   // first entry after the last square of the table
+   constexpr uint32_t magicTableEnd(const MagicTable& table){
+      return table[63].offset + (1U << (64 - table[63].shift));
+   }
+
+   // splitmix64 over a fixed seed, the n-th output is a pure function of n
+   constexpr uint64_t zobristKey(uint64_t n){
+      uint64_t z = 0x2545F4914F6CDD1DULL + (n + 1) * 0x9E3779B97F4A7C15ULL;
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+      return z ^ (z >> 31);
+   }
+
+   constexpr ZobristPieceTable zobristPieceTable(){
+      ZobristPieceTable table{};
+      for(int piece = 0; piece < 6; piece++){
+         for(int color = 0; color < 2; color++){
+            for(int sq = 0; sq < 64; sq++){
+               table[piece][color][sq] = zobristKey((piece * 2 + color) * 64 + sq);
+            }
+         }
+      }
+      return table;
+   }
+
+   template<size_t N>
+   constexpr std::array<uint64_t, N> zobristKeys(uint64_t first){
+      std::array<uint64_t, N> table{};
+      for(size_t i = 0; i < N; i++){
+         table[i] = zobristKey(first + i);
+      }
+      return table;
+   }
+}
+
+#endif
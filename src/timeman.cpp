@@ -0,0 +1,76 @@
+#include "timeman.hpp"
+
+namespace Mufasa{
+
+   void TimeManager::init(const Limits &limits, Color us, int gamephase){
+      const uint64_t time = (us == Color::WHITE) ? limits.wtime : limits.btime;
+      const uint64_t inc = (us == Color::WHITE) ? limits.winc : limits.binc;
+
+      soft = 0;
+      hard = 0;
+      fixed = limits.movetime != 0;
+      started = NEVER;
+
+      lastBest = nullmove;
+      lastScore = 0;
+      stable = 0;
+
+      if(limits.movetime){
+         soft = hard = std::max<uint64_t>(1, limits.movetime - std::min(limits.movetime, MOVE_OVERHEAD));
+      }
+      else if(time){
+         const uint64_t available = std::max<uint64_t>(1, time - std::min(time, MOVE_OVERHEAD));
+
+         // without moves to go, games with most of the material left are expected to last longer
+         const uint64_t movesLeft = limits.movestogo ? std::min(limits.movestogo, 50) : 20 + gamephase;
+
+         // the increment is mostly spent right away, a bit is kept as a reserve
+         soft = available / movesLeft + inc * 3 / 4;
+
+         // the last moves before the time control may use the whole clock
+         hard = std::min(soft * 4, available * 4 / 5 / std::min<uint64_t>(movesLeft, 4));
+         hard = std::max<uint64_t>(1, hard);
+         soft = std::clamp<uint64_t>(soft, 1, hard);
+      }
+   }
+
+   void TimeManager::start(uint64_t time){
+      started = time;
+   }
+
+   uint64_t TimeManager::deadline() const{
+      const uint64_t begin = started;
+      return (begin == NEVER || !hard) ? NEVER : begin + hard;
+   }
+
+   uint64_t TimeManager::getSoft() const{
+      return soft;
+   }
+
+   uint64_t TimeManager::getHard() const{
+      return hard;
+   }
+
+   bool TimeManager::enough(Move best, int score){
+      const bool first = (lastBest == nullmove);
+      const int drop = lastScore - score;
+
+      stable = (best == lastBest) ? stable + 1 : 0;
+      lastBest = best;
+      lastScore = score;
+
+      const uint64_t begin = started;
+      if(!soft || fixed || begin == NEVER) return false;
+
+      // in percent, by the number of iterations the best move survived
+      static const uint64_t stability[] = {140, 110, 90, 75, 60};
+      uint64_t scale = stability[std::min(stable, 4)];
+
+      // a falling score hints at trouble the next iteration may still find
+      if(!first && drop > 0) scale = scale * (100 + std::min(drop, 100)) / 100;
+
+      // the next iteration takes at least as long as all before it,
+      // one that cannot finish in time would only be cut off by the hard limit
+      return 2 * (now() - begin) >= soft * scale / 100;
+   }
+}
@@ -0,0 +1,48 @@
+#ifndef TIMEMAN_HPP_INCLUDED
+#define TIMEMAN_HPP_INCLUDED
+
+#include "bitboard.hpp"
+
+#include<atomic>
+
+namespace Mufasa{
+
+   // Splits the clock into a soft limit, after which no new iteration is started,
+   // and a hard limit, at which the running iteration is cut off
+   // The soft limit shrinks while the best move stays the same and grows when it changes or the score drops
+   class TimeManager{
+      public:
+      static constexpr uint64_t NEVER = UINT64_MAX;
+
+      // time lost between us sending the move and the clock of the opponent starting
+      static constexpr uint64_t MOVE_OVERHEAD = 20;
+
+      void init(const Limits &limits, Color us, int gamephase);
+
+      // the clock starts to run, when the search starts or on ponderhit
+      void start(uint64_t time);
+
+      // absolute time the search has to stop at, NEVER while pondering or without a clock
+      uint64_t deadline() const;
+
+      // called by the main thread after every finished iteration
+      bool enough(Move best, int score);
+
+      uint64_t getSoft() const;
+      uint64_t getHard() const;
+
+      private:
+      uint64_t soft = 0; // zero means no limit
+      uint64_t hard = 0;
+      bool fixed = false; // movetime is searched in full, no matter how stable the best move is
+
+      // written by ponderhit while the main thread reads it
+      std::atomic<uint64_t> started{NEVER};
+
+      Move lastBest = nullmove;
+      int lastScore = 0;
+      int stable = 0; // iterations in a row that kept the best move
+   };
+}
+
+#endif
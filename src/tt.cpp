@@ -0,0 +1,204 @@
+#include "tt.hpp"
+#include "numa.hpp"
+
+namespace Mufasa{
+   
+   TranspositionTable TT(DEFAULT_HASH);
+
+   // flags of every kind of move the generator produces, the index is stored in the entry
+   static const int moveKinds[] = {
+      0,
+      Move::DOUBLEPUSH,
+      Move::ENPASSANT | Move::CAPTURE,
+      Move::CASTLING | Move::KINGSIDE,
+      Move::CASTLING | Move::QUEENSIDE,
+      Move::PROMOTION | Move::TOQUEEN,
+      Move::PROMOTION | Move::TOROOK,
+      Move::PROMOTION | Move::TOBISHOP,
+      Move::PROMOTION | Move::TOKNIGHT,
+      Move::PROMOTION | Move::TOQUEEN  | Move::CAPTURE,
+      Move::PROMOTION | Move::TOROOK   | Move::CAPTURE,
+      Move::PROMOTION | Move::TOBISHOP | Move::CAPTURE,
+      Move::PROMOTION | Move::TOKNIGHT | Move::CAPTURE
+   };
+
+   static uint16_t packMove(const Move move){
+      int kind = 0;
+      while(moveKinds[kind] != move.getFlags()){
+         kind++;
+         assert(kind < 13);
+      }
+
+      return (kind << 12) | (move.end() << 6) | move.start();
+   }
+
+   static Move unpackMove(uint16_t packed){
+      if(!packed) return nullmove;
+      return Move(packed & 0x3F, (packed >> 6) & 0x3F, moveKinds[packed >> 12]);
+   }
+
+   // mate scores do not fit into 16 bits, anything beyond the bound is stored as the bound
+   static const int TT_BOUND = 32000;
+
+   static uint16_t packScore(int score){
+      return (uint16_t)std::clamp(score, -TT_BOUND, TT_BOUND);
+   }
+
+   static int unpackScore(uint16_t packed){
+      int score = (int16_t)packed;
+      if(score >=  TT_BOUND) return  oo;
+      if(score <= -TT_BOUND) return -oo;
+      return score;
+   }
+
+   static uint16_t fold(uint64_t data){
+      return (uint16_t)(data ^ (data >> 16) ^ (data >> 32) ^ (data >> 48));
+   }
+
+   TranspositionTable::TranspositionTable(size_t megabytes){
+      resize(megabytes);
+   }
+
+   TranspositionTable::~TranspositionTable(){
+      Numa::release(table, clusters * sizeof(TTCluster));
+   }
+
+   void TranspositionTable::resize(size_t megabytes){
+      size_t count = (std::clamp<size_t>(megabytes, 1, MAX_HASH) << 20) / sizeof(TTCluster);
+
+      if(count == clusters) return;
+
+      // free the old table first, both of them might not fit at once
+      Numa::release(table, clusters * sizeof(TTCluster));
+      table = nullptr;
+      clusters = 0;
+
+      table = static_cast<TTCluster*>(Numa::allocateInterleaved(count * sizeof(TTCluster)));
+      for(size_t i = 0; i < count; i++) new (&table[i]) TTCluster();
+      clusters = count;
+   }
+
+   void TranspositionTable::clear(){
+      for(size_t i = 0; i < clusters; i++){
+         for(int j = 0; j < TTCluster::size; j++){
+            table[i].data[j].store(0, std::memory_order_relaxed);
+            table[i].check[j].store(0, std::memory_order_relaxed);
+         }
+      }
+
+      generation = 0;
+   }
+
+   size_t TranspositionTable::size() const{
+      return clusters * TTCluster::size;
+   }
+
+   void TranspositionTable::newSearch(){
+      generation = (generation + 1) & 0x3F;
+   }
+
+   bool TranspositionTable::probe(uint64_t key, TTData &data) const{
+      const TTCluster &cluster = table[index(key)];
+
+      for(int i = 0; i < TTCluster::size; i++){
+         uint64_t entry = cluster.data[i].load(std::memory_order_relaxed);
+         uint16_t check = cluster.check[i].load(std::memory_order_relaxed);
+
+         // depth is stored one higher, so that empty entries never match
+         if((check ^ fold(entry)) == (uint16_t)key && (entry >> 48 & 0xFF)){
+            data.move  = unpackMove(entry & 0xFFFF);
+            data.score = unpackScore(entry >> 16 & 0xFFFF);
+            data.eval  = (int16_t)(entry >> 32 & 0xFFFF);
+            data.depth = (entry >> 48 & 0xFF) - 1;
+            data.type  = EntryType(entry >> 56 & 0x3);
+            return true;
+         }
+      }
+
+      return false;
+   }
+
+   // the entry of the same position is reused, otherwise the shallowest and oldest one is replaced
+   void TranspositionTable::store(uint64_t key, int depth, int score, int eval, Move move, EntryType type){
+      TTCluster &cluster = table[index(key)];
+
+      int replace = 0;
+      int worst = INT_MAX;
+      uint64_t previous = 0;
+
+      for(int i = 0; i < TTCluster::size; i++){
+         uint64_t entry = cluster.data[i].load(std::memory_order_relaxed);
+         uint16_t check = cluster.check[i].load(std::memory_order_relaxed);
+
+         if((check ^ fold(entry)) == (uint16_t)key && (entry >> 48 & 0xFF)){
+            replace = i;
+            previous = entry;
+            break;
+         }
+
+         int age = (generation - (entry >> 58)) & 0x3F;
+         int worth = (entry >> 48 & 0xFF) - 8 * age;
+
+         if(worth < worst){
+            worst = worth;
+            replace = i;
+         }
+      }
+
+      // keep the old move rather than forget it, the position did not change
+      uint64_t packed = (move == nullmove) ? (previous & 0xFFFF) : packMove(move);
+
+      packed |= (uint64_t)packScore(score) << 16;
+      packed |= (uint64_t)packScore(eval) << 32;
+      packed |= (uint64_t)std::clamp(depth + 1, 1, 255) << 48;
+      packed |= (uint64_t)((generation << 2) | type) << 56;
+
+      cluster.data[replace].store(packed, std::memory_order_relaxed);
+      cluster.check[replace].store((uint16_t)key ^ fold(packed), std::memory_order_relaxed);
+   }
+
+   PerftTable::PerftTable(size_t megabytes){
+      size_t buckets = 1;
+      size_t bytes = megabytes << 20;
+      
+      while(2 * buckets * 2 * sizeof(PerftEntry) <= bytes){
+         buckets *= 2;
+      }
+      
+      table.reset(new PerftEntry[2 * buckets]);
+      mask = buckets - 1;
+   }
+   
+   size_t PerftTable::bucket(uint64_t key, int depth) const{
+      // the same position at a different depth should not fight for the same bucket
+      uint64_t index = key ^ (0x9E3779B97F4A7C15ULL * depth);
+      return 2 * (index & mask);
+   }
+
+   bool PerftTable::probe(uint64_t key, int depth, uint64_t &nodes) const{
+      const PerftEntry* entry = &table[bucket(key, depth)];
+
+      for(int i = 0; i < 2; i++){
+         uint64_t data = entry[i].data.load(std::memory_order_relaxed);
+         uint64_t check = entry[i].check.load(std::memory_order_relaxed);
+
+         if((check ^ data) == key && (data & 0xFF) == (uint64_t)depth){
+            nodes = (data >> 8);
+            return true;
+         }
+      }
+
+      return false;
+   }
+
+   void PerftTable::store(uint64_t key, int depth, uint64_t nodes){
+      PerftEntry* entry = &table[bucket(key, depth)];
+      uint64_t data = (nodes << 8) | (uint64_t)depth;
+      
+      int deepest = (entry[0].data.load(std::memory_order_relaxed) & 0xFF);
+      if(depth < deepest) entry++;
+
+      entry->check.store(key ^ data, std::memory_order_relaxed);
+      entry->data.store(data, std::memory_order_relaxed);
+   }
+}
@@ -0,0 +1,110 @@
+#ifndef TT_HPP_INCLUDED
+#define TT_HPP_INCLUDED
+
+#include "bitboard.hpp"
+
+#include<atomic>
+#include<memory>
+#include<vector>
+#include<cstdint>
+
+namespace Mufasa{
+   
+   enum EntryType{
+      EXACT,
+      LOWER,
+      UPPER
+   };
+
+   // Transposition Table Cluster, three entries in half a cache line
+   // Every entry is packed into one word, so that it is read and written at once:
+   // move (16 bits, see packMove), score (16), eval (16), depth (8), generation (6) and EntryType (2)
+   // Threads write without locks, the check is the lower 16 bits of the key xored with the data folded to 16 bits,
+   // a data word from one write paired with the check of another then no longer matches the key
+   struct alignas(32) TTCluster{
+      static const int size = 3;
+      std::atomic<uint64_t> data[size];
+      std::atomic<uint16_t> check[size];
+   };
+
+   // Unpacked contents of an entry
+   struct TTData{
+      Move move;
+      int score;
+      int eval;
+      int depth;
+      EntryType type;
+   };
+
+   const size_t DEFAULT_HASH = 64;    // MB
+   const size_t MAX_HASH     = 65536; // MB
+
+   // Lives outside of the board, so that positions can be copied around freely
+   // Sized once by the Hash option and kept between the moves of a game
+   class TranspositionTable{
+      public:
+      TranspositionTable(size_t megabytes);
+      ~TranspositionTable();
+
+      TranspositionTable(const TranspositionTable&) = delete;
+      TranspositionTable& operator=(const TranspositionTable&) = delete;
+      
+      void resize(size_t megabytes);
+      void clear();
+      size_t size() const; // in entries
+
+      // entries of older searches are replaced first
+      void newSearch();
+
+      bool probe(uint64_t key, TTData &data) const;
+      void store(uint64_t key, int depth, int score, int eval, Move move, EntryType type);
+
+      // brings the cluster of the key into the cache ahead of the probe
+      void prefetch(uint64_t key) const{
+         __builtin_prefetch(&table[index(key)]);
+      }
+
+      private:
+      TTCluster* table = nullptr; // interleaved over the NUMA nodes
+      size_t clusters = 0;
+      uint8_t generation = 0;
+
+      // maps the key onto the clusters without needing a power of two of them
+      size_t index(uint64_t key) const{
+         return (size_t)(((unsigned __int128)key * clusters) >> 64);
+      }
+   };
+   
+   extern TranspositionTable TT;
+
+   // Entries are written without locks, the key is stored xored with the data,
+   // so an entry torn by two threads writing at once simply fails verification
+   struct PerftEntry{
+      std::atomic<uint64_t> check{0}; // key ^ data
+      std::atomic<uint64_t> data{0};  // node count in the upper 56 bits, depth in the lower 8
+   };
+
+   // one per thread, kept on its own cache line so that counting does not bounce lines between threads
+   struct alignas(64) PerftStats{
+      uint64_t probes = 0;
+      uint64_t hits = 0;
+   };
+
+   // Remembers node counts of subtrees that were already visited during perft
+   class PerftTable{
+      public:
+      PerftTable(size_t megabytes);
+      
+      bool probe(uint64_t key, int depth, uint64_t &nodes) const;
+      void store(uint64_t key, int depth, uint64_t nodes);
+
+      private:
+      std::unique_ptr<PerftEntry[]> table;
+      uint64_t mask;
+
+      // buckets of two, first entry keeps the deepest subtree, second one is always replaced
+      size_t bucket(uint64_t key, int depth) const;
+   };
+}
+
+#endif
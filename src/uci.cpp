@@ -18,12 +18,21 @@ namespace Mufasa{
          std::istringstream is(command);
          token.clear();
          is >> std::skipws >> token;
-         if(token == "quit" || token == "stop" || token == "q" || token == "exit"){
+         if(token == "quit" || token == "q" || token == "exit"){
             engine.stop();
-            break;
+            return;
+         }
+         else if(token == "stop"){
+            engine.stop();
+         }
+         else if(token == "ponderhit"){
+            engine.ponderhit();
          }
          else if(token == "ucinewgame"){
-            continue;
+            engine.clearHash();
+         }
+         else if(token == "setoption"){
+            setoption(is);
          }
          else if(token == "uci"){
             uci();
@@ -50,15 +59,56 @@ namespace Mufasa{
             std::cout << "Unknown command: '" << token << "'" << std::endl;
          }
       }
+
+      // input ran out, e.g. the GUI went away, nothing is left to end a search that waits for stop
+      engine.finish();
    }
    
    // @tissatussa remarks
    void UCI::uci(){
       std::cout << "id name Mufasa 0.2.1" << std::endl;
       std::cout << "id author Sirgaliyev Alikhan" << std::endl;
+      std::cout << "option name Hash type spin default " << DEFAULT_HASH << " min 1 max " << MAX_HASH << std::endl;
+      std::cout << "option name Clear Hash type button" << std::endl;
+      std::cout << "option name Threads type spin default 1 min 1 max " << MAX_THREADS << std::endl;
+      std::cout << "option name Bind Threads type check default true" << std::endl;
+      std::cout << "option name Ponder type check default false" << std::endl;
       std::cout << "uciok" << std::endl;
    }
 
+   // setoption name <id> [value <x>], names may contain spaces
+   void UCI::setoption(std::istringstream& is){
+      std::string token, name, value;
+      is >> token;
+      
+      while(is >> token && token != "value"){
+         name += (name.empty() ? "" : " ") + token;
+      }
+
+      while(is >> token){
+         value += (value.empty() ? "" : " ") + token;
+      }
+
+      if(name == "Hash"){
+         engine.setHash(std::max(0, std::stoi(value)));
+      }
+      else if(name == "Clear Hash"){
+         engine.clearHash();
+      }
+      else if(name == "Threads"){
+         engine.setThreads(std::stoi(value));
+      }
+      else if(name == "Bind Threads"){
+         engine.setBinding(value == "true");
+      }
+      else if(name == "Ponder"){
+         // only tells that the GUI may send go ponder, nothing to set up
+      }
+      else{
+         std::cout << "No such option: '" << name << "'" << std::endl;
+      }
+   }
+
    void UCI::go(std::istringstream& is){
       std::string token;
 
@@ -67,6 +117,11 @@ namespace Mufasa{
       uint16_t depth = 0;
       uint64_t wtime = 0;
       uint64_t btime = 0;
+      uint64_t winc = 0;
+      uint64_t binc = 0;
+      int movestogo = 0;
+      uint64_t movetime = 0;
+      bool ponder = false;
 
       while(is >> token){
          if(token == "depth"){
@@ -81,15 +136,29 @@ namespace Mufasa{
             is >> token;
             btime = std::stoi(token);
          }
+         else if(token == "winc"){
+            is >> token;
+            winc = std::stoi(token);
+         }
+         else if(token == "binc"){
+            is >> token;
+            binc = std::stoi(token);
+         }
+         else if(token == "movestogo"){
+            is >> token;
+            movestogo = std::stoi(token);
+         }
          else if(token == "movetime"){
             is >> token;
-            wtime = std::stoi(token);
-            btime = wtime;
+            movetime = std::stoi(token);
+         }
+         else if(token == "ponder"){
+            ponder = true;
          }
       }
 
-      Limits limits = {start, depth, wtime, btime, wtime};
-      engine.bestMove(limits);
+      Limits limits = {start, depth, wtime, btime, winc, binc, movestogo, movetime, ponder};
+      engine.go(limits);
    }
 
    void UCI::position(std::istringstream& is){
@@ -130,9 +199,27 @@ namespace Mufasa{
       std::string token;
       is >> token;
       int depth = std::stoi(token);
+      int threads = 1;
+      size_t hash = 0;
+
+      while(is >> token){
+         if(token == "threads"){
+            is >> token;
+            threads = std::max(1, std::stoi(token));
+         }
+         else if(token == "hash"){
+            is >> token;
+            hash = std::max(0, std::stoi(token));
+         }
+      }
+
+      uint64_t start = now();
+      uint64_t nodes = engine.perft(depth, threads, hash);
+      uint64_t duration = std::max<uint64_t>(1, now() - start);
 
-      uint64_t nodes = engine.perft(depth, depth);
-      std::cout << std::endl << "Nodes searched: " << nodes << std::endl << std::endl;
+      std::cout << std::endl << "Nodes searched: " << nodes << std::endl;
+      std::cout << "Time taken (ms): " << duration << std::endl;
+      std::cout << "Nodes per second: " << (nodes * 1000 / duration) << std::endl << std::endl;
       return nodes;
    }
 }
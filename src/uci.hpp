@@ -20,6 +20,7 @@ namespace Mufasa{
          
          void uci();
          void go(std::istringstream &is);
+         void setoption(std::istringstream &is);
          void bench(std::istringstream &is);
          void position(std::istringstream& is);
          uint64_t perft(std::istringstream& is);
@@ -1,5 +1,6 @@
 #include "../src/engine.hpp"
 #include<gtest/gtest.h>
+#include<random>
 
 using namespace Mufasa;
 
@@ -11,6 +12,11 @@ TEST(BitTwiddling, BitScanReverse){
    EXPECT_EQ(bitScanRev(3ULL), 1) << "Reverse bitscan returns different value";
 }
 
+TEST(BitTwiddling, Pext){
+   EXPECT_EQ(pext(0xF0ULL, 0x3CULL), 0xCULL);
+   EXPECT_EQ(pext(0x8000000000000001ULL, 0x8000000000000001ULL), 3ULL);
+}
+
 TEST(BitTwiddling, ColorShift){
    EXPECT_EQ(++Color::WHITE, Color::BLACK);
    EXPECT_EQ(++Color::BLACK, Color::WHITE);
@@ -27,20 +33,253 @@ class EngineTest : public testing::Test{
 TEST_F(EngineTest, StartPos){
    const std::string startpos = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
    engine.set_position(startpos);
-   uint64_t nodes = engine.perft(6, 6);
+   uint64_t nodes = engine.perft(6);
    EXPECT_EQ(nodes, 119060324) << "Perft(6) of initial position produces wrong node count";
 }
 
 TEST_F(EngineTest, Kiwipete){
    const std::string kiwipete = "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -";
    engine.set_position(kiwipete);
-   uint64_t nodes = engine.perft(6, 6);
+   uint64_t nodes = engine.perft(6);
    EXPECT_EQ(nodes, 8031647685) << "Perft(6) of kiwipete produces wrong node count";
 }
 
 TEST_F(EngineTest, Position3){
    const std::string position3 = "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - -";
    engine.set_position(position3);
-   uint64_t nodes = engine.perft(8, 8);
+   uint64_t nodes = engine.perft(8);
    EXPECT_EQ(nodes, 3009794393) << "Perft(8) of position 3 produces wrong node count";
 }
+
+TEST_F(EngineTest, ThreadedPerft){
+   const std::string kiwipete = "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -";
+   engine.set_position(kiwipete);
+   uint64_t nodes = engine.perft(5, 4);
+   EXPECT_EQ(nodes, 193690690) << "Perft(5) of kiwipete on 4 threads produces wrong node count";
+}
+
+TEST_F(EngineTest, HashedPerft){
+   const std::string position3 = "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - -";
+   engine.set_position(position3);
+   uint64_t nodes = engine.perft(7, 2, 16);
+   EXPECT_EQ(nodes, 178633661) << "Hashed perft(7) of position 3 produces wrong node count";
+}
+
+TEST_F(EngineTest, SliderAttacks){
+   std::mt19937_64 gen(2024);
+   for(int i = 0; i < 1000; i++){
+      uint64_t occupied = gen() & gen();
+      for(int sq = 0; sq < 64; sq++){
+         uint64_t bishop = Magics::getPositiveRayAttacks(occupied, 0, sq) | Magics::getPositiveRayAttacks(occupied, 1, sq) |
+                           Magics::getNegativeRayAttacks(occupied, 2, sq) | Magics::getNegativeRayAttacks(occupied, 3, sq);
+         uint64_t rook = Magics::getPositiveRayAttacks(occupied, 4, sq) | Magics::getPositiveRayAttacks(occupied, 5, sq) |
+                         Magics::getNegativeRayAttacks(occupied, 6, sq) | Magics::getNegativeRayAttacks(occupied, 7, sq);
+         ASSERT_EQ(Magics::getBishopAttacks(occupied, sq), bishop) << "Bishop attacks differ on square " << sq;
+         ASSERT_EQ(Magics::getRookAttacks(occupied, sq), rook) << "Rook attacks differ on square " << sq;
+      }
+   }
+}
+
+TEST(BoardTest, IncrementalEvaluation){
+   Magics::init();
+   const std::string startpos = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+   const std::string reached = "rnb1kbnr/ppp1pppp/8/3q4/8/2N5/PPPP1PPP/R1BQKBNR b KQkq - 1 3";
+
+   Bitboard played, loaded;
+   played.set_position(startpos, {"e2e4", "d7d5", "e4d5", "d8d5", "b1c3"});
+   loaded.set_position(reached, {});
+
+   EXPECT_EQ(played.evaluate(), loaded.evaluate()) << "Incremental score drifted from a fresh position";
+   EXPECT_EQ(played.gamephase(), loaded.gamephase());
+
+   Move move = played.moveFromUCI("d5a5");
+   int before = played.evaluate();
+   played.makeMove(move);
+   played.unmakeMove(move);
+   EXPECT_EQ(played.evaluate(), before) << "Unmaking a move does not restore the score";
+}
+
+TEST(BoardTest, CaptureAndQuietSplit){
+   Magics::init();
+   const std::string fens[] = {
+      "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+      "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+      "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+      "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1"
+   };
+
+   Bitboard board;
+   for(const auto &fen : fens){
+      board.set_position(fen, {});
+
+      MoveList moves, replies, captures, quiets;
+      board.fillMoves(moves);
+
+      for(const auto &move : moves){
+         board.makeMove(move);
+         board.fillMoves(replies);
+         board.fillMoves(captures, GenType::CAPTURE);
+         board.fillMoves(quiets, GenType::QUIET);
+
+         EXPECT_EQ(captures.size() + quiets.size(), replies.size()) << fen << " after " << move;
+
+         for(const auto &capture : captures){
+            EXPECT_TRUE(board.isCapture(capture) || (capture.getFlags() & Move::PROMOTION)) << capture;
+         }
+
+         for(const auto &quiet : quiets){
+            EXPECT_FALSE(board.isCapture(quiet) || (quiet.getFlags() & Move::PROMOTION)) << quiet;
+         }
+
+         board.unmakeMove(move);
+      }
+   }
+}
+
+TEST(BoardTest, StaticExchange){
+   Magics::init();
+   Bitboard board;
+
+   board.set_position("1k1r4/1pp4p/p7/4p3/8/P5P1/1PP4P/2K1R3 w - - 0 1", {});
+   EXPECT_EQ(board.see(board.moveFromUCI("e1e5")), 100) << "Undefended pawn is won outright";
+
+   board.set_position("1k1r3q/1ppn3p/p4b2/4p3/8/P2N2P1/1PP1R1BP/2K1Q3 w - - 0 1", {});
+   EXPECT_LT(board.see(board.moveFromUCI("d3e5")), 0) << "Knight for a pawn after the x-ray recaptures";
+
+   board.set_position("4k3/8/3p4/4p3/3P4/8/8/4K3 w - - 0 1", {});
+   EXPECT_GE(board.see(board.moveFromUCI("d4e5")), 0) << "Pawn trade does not lose material";
+}
+
+TEST(TTTest, ResizeAndClear){
+   TranspositionTable table(1);
+   EXPECT_LE(table.size() / TTCluster::size * sizeof(TTCluster), size_t(1) << 20) << "Table is bigger than requested";
+
+   TTData data;
+   const Move promotion(52, 61, Move::PROMOTION | Move::TOKNIGHT | Move::CAPTURE);
+   table.store(0x1234ULL, 5, 42, 17, promotion, EXACT);
+   ASSERT_TRUE(table.probe(0x1234ULL, data)) << "Stored entry is not found";
+   EXPECT_EQ(data.move, promotion) << "Move is not restored from the packed entry";
+   EXPECT_EQ(data.score, 42);
+   EXPECT_EQ(data.eval, 17);
+   EXPECT_EQ(data.depth, 5);
+   EXPECT_EQ(data.type, EXACT);
+
+   table.store(0x1234ULL, 7, oo, 0, nullmove, UPPER);
+   ASSERT_TRUE(table.probe(0x1234ULL, data));
+   EXPECT_EQ(data.move, promotion) << "Storing no move forgets the old one";
+   EXPECT_EQ(data.score, oo) << "Mate score does not survive packing";
+
+   table.resize(2);
+   EXPECT_FALSE(table.probe(0x1234ULL, data)) << "Resized table keeps stale entries";
+
+   table.store(0x1234ULL, 5, 42, 17, promotion, EXACT);
+   table.clear();
+   EXPECT_FALSE(table.probe(0x1234ULL, data)) << "Cleared table keeps entries";
+}
+
+TEST_F(EngineTest, ThreadedSearch){
+   engine.setThreads(3);
+   engine.set_position("6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1");
+
+   testing::internal::CaptureStdout();
+   engine.bestMove({now(), 4, 0, 0, 0});
+   std::string output = testing::internal::GetCapturedStdout();
+
+   EXPECT_NE(output.find("bestmove a1a8"), std::string::npos) << "Threads do not agree on the mate in one";
+}
+
+TEST_F(EngineTest, PonderWaitsForPonderhit){
+   engine.set_position("rnbqkbnr/pppp1ppp/8/4p3/4P3/8/PPPP1PPP/RNBQKBNR w KQkq - 0 2");
+
+   // depth 3 is over long before, yet nothing is reported while pondering
+   Limits limits{now(), 3, 0, 0};
+   limits.ponder = true;
+
+   testing::internal::CaptureStdout();
+   engine.go(limits);
+   std::this_thread::sleep_for(std::chrono::milliseconds(200));
+   std::string output = testing::internal::GetCapturedStdout();
+   EXPECT_EQ(output.find("bestmove"), std::string::npos) << "Move reported before ponderhit";
+
+   testing::internal::CaptureStdout();
+   engine.ponderhit();
+   engine.wait();
+   output = testing::internal::GetCapturedStdout();
+
+   size_t bestmove = output.find("bestmove");
+   ASSERT_NE(bestmove, std::string::npos) << "No move reported after ponderhit";
+   EXPECT_NE(output.find(" ponder ", bestmove), std::string::npos) << "Expected reply is not reported";
+}
+
+TEST(TimeManagerTest, SoftAndHardLimits){
+   TimeManager manager;
+
+   Limits limits{now(), 0, 60000, 1000};
+   manager.init(limits, Color::WHITE, 24);
+   uint64_t suddenDeath = manager.getSoft();
+   EXPECT_GT(suddenDeath, 0u);
+   EXPECT_LE(suddenDeath, manager.getHard());
+   EXPECT_LE(manager.getHard(), 60000u / 5) << "Hard limit risks the rest of the game";
+
+   manager.init(limits, Color::BLACK, 24);
+   EXPECT_LT(manager.getSoft(), suddenDeath) << "Clock of the wrong side is used";
+
+   limits.winc = 2000;
+   manager.init(limits, Color::WHITE, 24);
+   EXPECT_GT(manager.getSoft(), suddenDeath) << "Increment is ignored";
+
+   limits.winc = 0;
+   limits.movestogo = 5;
+   manager.init(limits, Color::WHITE, 24);
+   EXPECT_GT(manager.getSoft(), suddenDeath) << "Moves to go are ignored";
+
+   limits.movetime = 500;
+   manager.init(limits, Color::WHITE, 24);
+   EXPECT_EQ(manager.getSoft(), manager.getHard());
+   EXPECT_LE(manager.getHard(), 500u);
+
+   // the clock only runs once started
+   EXPECT_EQ(manager.deadline(), TimeManager::NEVER);
+   manager.start(limits.start);
+   EXPECT_EQ(manager.deadline(), limits.start + manager.getHard());
+
+   // a stable best move ends clock games early, but never a fixed move time
+   manager.start(now() - 400);
+   for(int iteration = 0; iteration < 5; iteration++){
+      EXPECT_FALSE(manager.enough(Move(12, 28), 20)) << "Move time is cut short";
+   }
+
+   manager.init(Limits{now(), 5, 0, 0}, Color::WHITE, 24);
+   manager.start(now());
+   EXPECT_EQ(manager.deadline(), TimeManager::NEVER) << "Depth limited search has a deadline";
+   EXPECT_FALSE(manager.enough(nullmove, 0));
+}
+
+TEST_F(EngineTest, SingleLegalMoveIsPlayedAtOnce){
+   // the rook covers the b-file, so the king can only go to a2
+   engine.set_position("1r6/8/8/8/8/2k5/8/K7 w - - 0 1");
+
+   testing::internal::CaptureStdout();
+   engine.bestMove({now(), 0, 60000, 60000});
+   std::string output = testing::internal::GetCapturedStdout();
+
+   EXPECT_NE(output.find("bestmove a1a2"), std::string::npos);
+   EXPECT_EQ(output.find("info depth 2"), std::string::npos) << "Search goes on with a single legal move";
+}
+
+TEST(NumaTest, PlacementAndAllocation){
+   EXPECT_GE(Numa::nodes(), 1);
+   for(int thread = 0; thread < 8; thread++){
+      EXPECT_LT(Numa::nodeOf(thread), Numa::nodes()) << "Thread is put on a node that does not exist";
+   }
+
+   const size_t bytes = 3 << 20;
+   uint8_t* memory = static_cast<uint8_t*>(Numa::allocateInterleaved(bytes));
+   ASSERT_NE(memory, nullptr);
+   EXPECT_EQ(reinterpret_cast<uintptr_t>(memory) % 64, 0u) << "Interleaved memory is not cache line aligned";
+
+   memory[0] = 1;
+   memory[bytes - 1] = 2;
+   EXPECT_EQ(memory[0] + memory[bytes - 1], 3);
+   Numa::release(memory, bytes);
+}